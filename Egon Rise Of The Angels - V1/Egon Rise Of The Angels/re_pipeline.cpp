@@ -1,5 +1,6 @@
 #include "re_pipeline.hpp"
 #include "te_model.hpp"
+#include "te_file.hpp"
 #include <fstream>
 #include <stdexcept>
 
@@ -9,25 +10,10 @@ namespace te {
 		vkCmdBindPipeline(commandBufffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 	}
 	std::vector<char> TePipeline::readFile(const std::string& filepath) {
-		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
-		if (!file.is_open()) {
-			throw std::runtime_error{ "failed to open file!" + filepath };
-		}
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(fileSize);
-		file.seekg(0);
-		file.read(buffer.data(), fileSize);
-		file.close();
-		return buffer;
+		return TeFile::read(filepath);
 	}
 	void TePipeline::writeToFile(const std::string& filepath, const std::vector<char>& data) {
-		std::ofstream file{ filepath, std::ios::binary };
-		if (!file.is_open()) {
-			throw std::runtime_error{ "failed to open file!" + filepath };
-		}
-		file.write(data.data(), data.size());
-		file.close();
-	
+		TeFile::write(filepath, data);
 	}
 	TePipeline::TePipeline(TeDevice& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) : teDevice{ device } {
 		createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
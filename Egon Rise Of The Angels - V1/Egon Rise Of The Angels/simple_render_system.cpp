@@ -56,7 +56,7 @@ namespace te {
 			pipelineConfig);
 	}
 
-	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
+	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo, const TransformSystem& transforms) {
 		tePipeline->bind(frameInfo.commandBuffer);
 
 		vkCmdBindDescriptorSets(
@@ -70,16 +70,12 @@ namespace te {
 			nullptr);
 
 		TeScene* scene = frameInfo.scene;
-		for (auto& objModelComponentAndContainer : scene->getComponentInstances<ModelComponent>()) {
-			TeScene::Entity obj = objModelComponentAndContainer.first;
-			ModelComponent* objModelComponent = objModelComponentAndContainer.second;
-			std::shared_ptr<TeModel> objModel = objModelComponent->model;
-			TransformComponent* objTransformComponent = scene->getComponent<TransformComponent>(obj);
-			if (objTransformComponent == nullptr) continue;
+		for (auto [obj, objTransformComponent, objModelComponent] : scene->view<const TransformComponent, const ModelComponent>()) {
+			TeModel* objModel = objModelComponent.model.get();
 
 			SimplePushConstantData push{};
-			push.modelMatrix = objTransformComponent->mat4();
-			push.normalMatrix = objTransformComponent->normalMatrix();
+			push.modelMatrix = transforms.getModelMatrix(obj);
+			push.normalMatrix = transforms.getNormalMatrix(obj);
 
 			vkCmdPushConstants(
 				frameInfo.commandBuffer,
@@ -13,11 +13,13 @@
 #include "re_pipeline.hpp"
 #include "te_model.hpp"
 #include "te_descriptors.hpp"
+#include "transform_system.hpp"
 
 namespace te {
 	class SimpleRenderSystem {
 	public:
-		void renderGameObjects(te::FrameInfo& frameInfo);
+		// Model and normal matrices come from transforms, which has to be updated first
+		void renderGameObjects(te::FrameInfo& frameInfo, const TransformSystem& transforms);
 
 		SimpleRenderSystem(TeDevice& device, VkRenderPass renderPass, std::unique_ptr<TeDescriptorSetLayout>& globalSetLayout, std::unique_ptr<TeDescriptorPool>& globalPool);
 		~SimpleRenderSystem();
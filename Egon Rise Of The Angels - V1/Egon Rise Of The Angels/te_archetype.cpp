@@ -0,0 +1,165 @@
+#include "te_archetype.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace te {
+	TeComponentTypeId nextComponentTypeId() {
+		static std::atomic<TeComponentTypeId> nextId{ 0 };
+		return nextId++;
+	}
+
+	TeChunkAllocator::~TeChunkAllocator() {
+		for (char* slab : slabs_) {
+			::operator delete(slab, std::align_val_t{ TeChunk::ALIGNMENT });
+		}
+	}
+
+	char* TeChunkAllocator::allocate() {
+		if (freeChunks_.empty()) {
+			char* slab = static_cast<char*>(::operator new(CHUNKS_PER_SLAB * TeChunk::SIZE, std::align_val_t{ TeChunk::ALIGNMENT }));
+			slabs_.push_back(slab);
+			for (size_t i = CHUNKS_PER_SLAB; i > 0; i--) {
+				freeChunks_.push_back(slab + (i - 1) * TeChunk::SIZE);
+			}
+		}
+		char* chunk = freeChunks_.back();
+		freeChunks_.pop_back();
+		chunksInUse_++;
+		return chunk;
+	}
+
+	void TeChunkAllocator::free(char* chunk) {
+		freeChunks_.push_back(chunk);
+		chunksInUse_--;
+	}
+
+	TeArchetype::TeArchetype(std::vector<const TeComponentInfo*> components, TeChunkAllocator& allocator) : allocator_{ allocator }, components_{ std::move(components) } {
+		size_t rowSize = sizeof(TeEntity);
+		for (size_t column = 0; column < components_.size(); column++) {
+			rowSize += components_[column]->size + sizeof(uint32_t);
+			if (components_[column]->id >= columnsById_.size()) {
+				columnsById_.resize(components_[column]->id + 1, -1);
+			}
+			columnsById_[components_[column]->id] = static_cast<int>(column);
+		}
+
+		// Fit as many rows as possible into one chunk, a row bigger than a chunk still gets one
+		chunkCapacity_ = static_cast<uint32_t>(std::max<size_t>(TeChunk::SIZE / rowSize, 1));
+		while (chunkCapacity_ > 1 && computeLayout(chunkCapacity_) > TeChunk::SIZE) {
+			chunkCapacity_--;
+		}
+		chunkBytes_ = computeLayout(chunkCapacity_);
+	}
+
+	TeArchetype::~TeArchetype() {
+		for (auto* chunk : chunks_) {
+			for (uint32_t row = 0; row < chunk->count; row++) {
+				for (size_t column = 0; column < components_.size(); column++) {
+					components_[column]->destroy(chunk->columns[column] + row * components_[column]->size);
+				}
+			}
+			freeChunk(chunk);
+		}
+	}
+
+	size_t TeArchetype::computeLayout(uint32_t capacity) {
+		columnOffsets_.clear();
+		size_t offset = sizeof(TeEntity) * capacity;
+		for (auto* component : components_) {
+			size_t alignment = std::max(component->alignment, TeChunk::ALIGNMENT);
+			offset = (offset + alignment - 1) & ~(alignment - 1);
+			columnOffsets_.push_back(offset);
+			offset += component->size * capacity;
+		}
+		versionOffsets_.clear();
+		// Columns of components whose size isn't a multiple of 4 can leave the offset unaligned
+		offset = (offset + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1);
+		for (size_t column = 0; column < components_.size(); column++) {
+			versionOffsets_.push_back(offset);
+			offset += sizeof(uint32_t) * capacity;
+		}
+		return offset;
+	}
+
+	TeChunk* TeArchetype::createChunk() {
+		TeChunk* chunk = new TeChunk();
+		// Rows bigger than a chunk are the only thing that doesn't fit the allocator's blocks
+		if (chunkBytes_ <= TeChunk::SIZE) {
+			chunk->memory = allocator_.allocate();
+		}
+		else {
+			chunk->memory = static_cast<char*>(::operator new(chunkBytes_, std::align_val_t{ TeChunk::ALIGNMENT }));
+		}
+		chunk->entities = reinterpret_cast<TeEntity*>(chunk->memory);
+		chunk->columns.reserve(components_.size());
+		for (size_t offset : columnOffsets_) {
+			chunk->columns.push_back(chunk->memory + offset);
+		}
+		chunk->versions.reserve(components_.size());
+		for (size_t offset : versionOffsets_) {
+			chunk->versions.push_back(reinterpret_cast<uint32_t*>(chunk->memory + offset));
+		}
+		chunk->columnVersions.assign(components_.size(), 0);
+		return chunk;
+	}
+
+	void TeArchetype::freeChunk(TeChunk* chunk) {
+		if (chunkBytes_ <= TeChunk::SIZE) {
+			allocator_.free(chunk->memory);
+		}
+		else {
+			::operator delete(chunk->memory, std::align_val_t{ TeChunk::ALIGNMENT });
+		}
+		delete chunk;
+	}
+
+	TeArchetype::Location TeArchetype::allocateRow(TeEntity entity) {
+		if (chunks_.empty() || chunks_.back()->count == chunkCapacity_) {
+			chunks_.push_back(createChunk());
+		}
+		TeChunk* chunk = chunks_.back();
+		Location location{ static_cast<uint32_t>(chunks_.size() - 1), chunk->count++ };
+		chunk->entities[location.row] = entity;
+		return location;
+	}
+
+	TeEntity TeArchetype::removeRow(Location location) {
+		TeChunk* chunk = chunks_[location.chunk];
+		TeChunk* last = chunks_.back();
+		uint32_t lastRow = last->count - 1;
+
+		if (chunk != last || location.row != lastRow) {
+			for (size_t column = 0; column < components_.size(); column++) {
+				size_t size = components_[column]->size;
+				void* src = last->columns[column] + lastRow * size;
+				components_[column]->moveConstruct(chunk->columns[column] + location.row * size, src);
+				components_[column]->destroy(src);
+				chunk->markChanged(column, location.row, last->versions[column][lastRow]);
+			}
+			chunk->entities[location.row] = last->entities[lastRow];
+		}
+		TeEntity entity = chunk->entities[location.row];
+
+		last->count--;
+		if (last->count == 0) {
+			freeChunk(last);
+			chunks_.pop_back();
+		}
+		return entity;
+	}
+
+	void TeArchetype::destroyRow(Location location) {
+		TeChunk* chunk = chunks_[location.chunk];
+		for (size_t column = 0; column < components_.size(); column++) {
+			components_[column]->destroy(chunk->columns[column] + location.row * components_[column]->size);
+		}
+	}
+
+	size_t TeArchetype::getEntityCount() const {
+		if (chunks_.empty()) {
+			return 0;
+		}
+		return (chunks_.size() - 1) * chunkCapacity_ + chunks_.back()->count;
+	}
+}
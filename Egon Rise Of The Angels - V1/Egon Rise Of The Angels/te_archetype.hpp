@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+namespace te {
+	// Entity handle: a slot index that gets recycled, plus a generation that is bumped
+	// every time the slot is freed so stale handles can be told apart from live ones
+	struct TeEntity {
+		static constexpr uint32_t NULL_INDEX = UINT32_MAX;
+
+		uint32_t index = NULL_INDEX;
+		uint32_t generation = 0;
+
+		bool isNull() const { return index == NULL_INDEX; }
+		bool operator==(const TeEntity& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const TeEntity& other) const { return !(*this == other); }
+	};
+
+	using TeComponentTypeId = uint32_t;
+
+	// Dense ids handed out the first time each component type is used, so per-type
+	// storage can live in flat arrays instead of maps keyed by std::type_index
+	TeComponentTypeId nextComponentTypeId();
+
+	template<typename T>
+	struct TeComponentTypeIdOf {
+		static TeComponentTypeId get() {
+			static const TeComponentTypeId id = nextComponentTypeId();
+			return id;
+		}
+	};
+
+	template<typename T>
+	TeComponentTypeId getComponentTypeId() {
+		return TeComponentTypeIdOf<std::remove_cv_t<std::remove_reference_t<T>>>::get();
+	}
+
+	// Where a scene keeps a component type. Archetype storage is fastest to iterate,
+	// sparse sets make adding and removing the component cheap since the entity never moves
+	enum class TeStoragePolicy {
+		Archetype,
+		SparseSet
+	};
+
+	// Type-erased operations for a component type, so archetype storage can
+	// move, copy and destroy components without knowing what they are
+	struct TeComponentInfo {
+		std::type_index type = typeid(void);
+		TeComponentTypeId id = 0;
+		TeStoragePolicy storage = TeStoragePolicy::Archetype;
+		size_t size = 0;
+		size_t alignment = 1;
+		// Trivially copyable, so the raw bytes of an instance are a valid copy of it
+		bool trivial = false;
+		void (*moveConstruct)(void* dst, void* src) = nullptr;
+		// Null if T can't be move assigned. Replacing such a component destroys it and move constructs
+		// over it, so its move constructor mustn't throw
+		void (*moveAssign)(void* dst, void* src) = nullptr;
+		void (*copyConstruct)(void* dst, const void* src) = nullptr;
+		void (*destroy)(void* component) = nullptr;
+		// Destroys and frees a component allocated with ::operator new(size, std::align_val_t{ alignment })
+		void (*deleteInstance)(void* component) = nullptr;
+
+		template<typename T>
+		static TeComponentInfo of();
+	};
+
+	// Fixed-size block holding rows of a single archetype: the entity ids
+	// followed by one contiguous array per component type
+	struct TeChunk {
+		static constexpr size_t SIZE = 16 * 1024;
+		static constexpr size_t ALIGNMENT = 64;
+
+		char* memory = nullptr;
+		TeEntity* entities = nullptr;
+		std::vector<char*> columns;
+		uint32_t count = 0;
+
+		// Per column, the change version of every row and the newest version of any row in the
+		// chunk, so change queries can skip whole chunks nobody wrote to
+		std::vector<uint32_t*> versions;
+		std::vector<uint32_t> columnVersions;
+
+		void markChanged(size_t column, uint32_t row, uint32_t version) {
+			versions[column][row] = version;
+			if (columnVersions[column] < version) {
+				columnVersions[column] = version;
+			}
+		}
+	};
+
+	// Hands out TeChunk::SIZE blocks carved from larger slabs and recycles freed blocks through a
+	// free list, so spawn waves don't hit the system allocator. Slabs all go back in one go when
+	// the allocator is destroyed
+	class TeChunkAllocator {
+	public:
+		static constexpr size_t CHUNKS_PER_SLAB = 64;
+
+		TeChunkAllocator() = default;
+		~TeChunkAllocator();
+
+		TeChunkAllocator(const TeChunkAllocator&) = delete;
+		TeChunkAllocator& operator=(const TeChunkAllocator&) = delete;
+
+		char* allocate();
+		void free(char* chunk);
+
+		size_t getBytesReserved() const { return slabs_.size() * CHUNKS_PER_SLAB * TeChunk::SIZE; }
+		size_t getBytesInUse() const { return chunksInUse_ * TeChunk::SIZE; }
+	private:
+		std::vector<char*> slabs_;
+		std::vector<char*> freeChunks_;
+		size_t chunksInUse_ = 0;
+	};
+
+	// Stores every entity that has exactly the same set of components. Rows are
+	// kept dense: every chunk but the last is full and removal swaps in the last row
+	class TeArchetype {
+	public:
+		struct Location {
+			uint32_t chunk;
+			uint32_t row;
+		};
+
+		TeArchetype(std::vector<const TeComponentInfo*> components, TeChunkAllocator& allocator);
+		~TeArchetype();
+
+		TeArchetype(const TeArchetype&) = delete;
+		TeArchetype& operator=(const TeArchetype&) = delete;
+
+		// Reserves a row for the entity, components are left unconstructed
+		Location allocateRow(TeEntity entity);
+
+		// Fills the row with the last row of the archetype. Components in the row must already
+		// be moved out or destroyed. Returns the entity that now lives at location
+		TeEntity removeRow(Location location);
+
+		void destroyRow(Location location);
+
+		int getColumn(TeComponentTypeId id) const {
+			return id < columnsById_.size() ? columnsById_[id] : -1;
+		}
+
+		void* getComponent(Location location, size_t column) {
+			return chunks_[location.chunk]->columns[column] + location.row * components_[column]->size;
+		}
+
+		void markChanged(Location location, size_t column, uint32_t version) {
+			chunks_[location.chunk]->markChanged(column, location.row, version);
+		}
+
+		uint32_t getVersion(Location location, size_t column) const {
+			return chunks_[location.chunk]->versions[column][location.row];
+		}
+
+		const std::vector<const TeComponentInfo*>& getComponents() const { return components_; }
+		const std::vector<TeChunk*>& getChunks() const { return chunks_; }
+		uint32_t getChunkCapacity() const { return chunkCapacity_; }
+		size_t getEntityCount() const;
+
+		// Bytes the column's components take up, and bytes reserved for them in this archetype's chunks
+		size_t getColumnBytesUsed(size_t column) const { return getEntityCount() * components_[column]->size; }
+		size_t getColumnBytesReserved(size_t column) const { return chunks_.size() * chunkCapacity_ * components_[column]->size; }
+
+		// Cached archetype graph transitions indexed by component type id, filled in lazily by the scene
+		std::vector<TeArchetype*> addEdges;
+		std::vector<TeArchetype*> removeEdges;
+	private:
+		size_t computeLayout(uint32_t capacity);
+		TeChunk* createChunk();
+		void freeChunk(TeChunk* chunk);
+
+		TeChunkAllocator& allocator_;
+
+		std::vector<const TeComponentInfo*> components_;
+		std::vector<int> columnsById_;
+		std::vector<size_t> columnOffsets_;
+		std::vector<size_t> versionOffsets_;
+		size_t chunkBytes_ = 0;
+		uint32_t chunkCapacity_ = 0;
+
+		std::vector<TeChunk*> chunks_;
+	};
+
+	template<typename T>
+	TeComponentInfo TeComponentInfo::of() {
+		TeComponentInfo info{};
+		info.type = typeid(T);
+		info.id = getComponentTypeId<T>();
+		info.size = sizeof(T);
+		info.alignment = alignof(T);
+		info.trivial = std::is_trivially_copyable_v<T>;
+		info.moveConstruct = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); };
+		if constexpr (std::is_move_assignable_v<T>) {
+			info.moveAssign = [](void* dst, void* src) { *static_cast<T*>(dst) = std::move(*static_cast<T*>(src)); };
+		}
+		if constexpr (std::is_copy_constructible_v<T>) {
+			info.copyConstruct = [](void* dst, const void* src) { new (dst) T(*static_cast<const T*>(src)); };
+		}
+		info.destroy = [](void* component) { static_cast<T*>(component)->~T(); };
+		info.deleteInstance = [](void* component) {
+			static_cast<T*>(component)->~T();
+			::operator delete(component, std::align_val_t{ alignof(T) });
+		};
+		return info;
+	}
+}
+
+namespace std {
+	template<>
+	struct hash<te::TeEntity> {
+		size_t operator()(const te::TeEntity& entity) const {
+			return hash<uint64_t>{}((static_cast<uint64_t>(entity.generation) << 32) | entity.index);
+		}
+	};
+}
@@ -0,0 +1,24 @@
+#include "te_archive.hpp"
+
+#include <algorithm>
+
+namespace te {
+	TeComponentArray::TeComponentArray(const TeComponentInfo& info, size_t capacity) : info_{ info }, capacity_{ capacity } {
+		data_ = static_cast<char*>(::operator new(std::max<size_t>(capacity * info_.size, 1), std::align_val_t{ info_.alignment }));
+	}
+
+	TeComponentArray::~TeComponentArray() {
+		for (size_t i = 0; i < count_; i++) {
+			info_.destroy(get(i));
+		}
+		::operator delete(data_, std::align_val_t{ info_.alignment });
+	}
+
+	void TeComponentArray::read(void (*readFunc)(void*, TeArchiveReader&), TeArchiveReader& reader) {
+		if (count_ == capacity_) {
+			throw std::runtime_error("component array is full");
+		}
+		readFunc(get(count_), reader);
+		count_++;
+	}
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "te_archetype.hpp"
+#include "te_reflect.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace te {
+	// Appends binary data to an arena the caller owns. Clearing the arena and reusing it for the
+	// next save keeps its capacity, so steady state saving doesn't allocate at all
+	class TeArchiveWriter {
+	public:
+		TeArchiveWriter(std::vector<char>& arena) : arena{ arena } {}
+
+		void write(const void* data, size_t size) {
+			const char* bytes = static_cast<const char*>(data);
+			arena.insert(arena.end(), bytes, bytes + size);
+		}
+
+		template<typename T>
+		void write(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be written as bytes");
+			write(&value, sizeof(T));
+		}
+
+		void writeString(std::string_view string) {
+			write<uint64_t>(string.size());
+			write(string.data(), string.size());
+		}
+
+		// Leaves room for bytes that are only known once what follows them is written, see patch.
+		// Returns their offset in the arena
+		size_t reserve(size_t size) {
+			size_t offset = arena.size();
+			arena.resize(offset + size);
+			return offset;
+		}
+
+		template<typename T>
+		size_t reserve() { return reserve(sizeof(T)); }
+
+		template<typename T>
+		void patch(size_t offset, const T& value) {
+			std::memcpy(arena.data() + offset, &value, sizeof(T));
+		}
+
+		// Pads with zeros until the arena is a multiple of alignment bytes past origin
+		void align(size_t alignment, size_t origin = 0) {
+			arena.resize(arena.size() + (alignment - (arena.size() - origin) % alignment) % alignment);
+		}
+
+		size_t size() const { return arena.size(); }
+		char* data() { return arena.data(); }
+	private:
+		std::vector<char>& arena;
+	};
+
+	// Bounds checked cursor over binary data, throws once a read would run past the end. Nothing is
+	// assumed to be aligned, values are copied out
+	class TeArchiveReader {
+	public:
+		TeArchiveReader(const char* data, size_t size) : data_{ data }, size_{ size } {}
+
+		const char* read(size_t size) {
+			if (size > size_ - offset_) {
+				throw std::runtime_error("archive is truncated");
+			}
+			const char* start = data_ + offset_;
+			offset_ += size;
+			return start;
+		}
+
+		template<typename T>
+		T read() {
+			static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be read as bytes");
+			T value;
+			std::memcpy(&value, read(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		// Points into the archive, so it's only valid as long as the data is
+		std::string_view readString() {
+			uint64_t size = read<uint64_t>();
+			if (size > size_ - offset_) {
+				throw std::runtime_error("archive is truncated");
+			}
+			return std::string_view(read(static_cast<size_t>(size)), static_cast<size_t>(size));
+		}
+
+		// Reader over the next size bytes, which this reader skips
+		TeArchiveReader readArchive(size_t size) { return TeArchiveReader(read(size), size); }
+
+		// Skips to the next offset from the start of the data that is a multiple of alignment
+		void align(size_t alignment) { read((alignment - offset_ % alignment) % alignment); }
+
+		size_t getOffset() const { return offset_; }
+		size_t getRemaining() const { return size_ - offset_; }
+		bool isEmpty() const { return offset_ == size_; }
+	private:
+		const char* data_;
+		size_t size_;
+		size_t offset_ = 0;
+	};
+
+	template<typename T, typename = void>
+	struct TeHasArchiveSerialize : std::false_type {};
+
+	template<typename T>
+	struct TeHasArchiveSerialize<T, std::void_t<
+		decltype(T::serialize(std::declval<const T&>(), std::declval<TeArchiveWriter&>())),
+		decltype(T::deserialize(std::declval<T&>(), std::declval<TeArchiveReader&>()))>> : std::true_type {};
+
+	template<typename T, typename = void>
+	struct TeHasVectorSerialize : std::false_type {};
+
+	template<typename T>
+	struct TeHasVectorSerialize<T, std::void_t<
+		decltype(T::serialize(std::declval<void*>())),
+		decltype(T::deserialize(std::declval<std::vector<char>>()))>> : std::true_type {};
+
+	template<typename T>
+	void teWriteFields(TeArchiveWriter& writer, const T& object);
+
+	template<typename T>
+	void teReadFields(TeArchiveReader& reader, T& object);
+
+	// One member of a reflected type. Plain data is copied as bytes, vectors of it in one go
+	template<typename M>
+	void teWriteField(TeArchiveWriter& writer, const M& value) {
+		if constexpr (TeHasArchiveSerialize<M>::value) {
+			M::serialize(value, writer);
+		}
+		else if constexpr (TeHasFields<M>::value) {
+			teWriteFields(writer, value);
+		}
+		else if constexpr (std::is_same_v<M, std::string>) {
+			writer.writeString(value);
+		}
+		else if constexpr (TeIsVector<M>::value) {
+			writer.write<uint64_t>(value.size());
+			if constexpr (std::is_trivially_copyable_v<typename M::value_type>) {
+				writer.write(value.data(), value.size() * sizeof(typename M::value_type));
+			}
+			else {
+				for (const auto& element : value) {
+					teWriteField(writer, element);
+				}
+			}
+		}
+		else {
+			static_assert(std::is_trivially_copyable_v<M>, "field type can't be serialized, give it fields() or serialize hooks");
+			writer.write(value);
+		}
+	}
+
+	template<typename M>
+	void teReadField(TeArchiveReader& reader, M& value) {
+		if constexpr (TeHasArchiveSerialize<M>::value) {
+			M::deserialize(value, reader);
+		}
+		else if constexpr (TeHasFields<M>::value) {
+			teReadFields(reader, value);
+		}
+		else if constexpr (std::is_same_v<M, std::string>) {
+			value = reader.readString();
+		}
+		else if constexpr (TeIsVector<M>::value) {
+			using Element = typename M::value_type;
+			uint64_t count = reader.read<uint64_t>();
+			value.clear();
+			if constexpr (std::is_trivially_copyable_v<Element>) {
+				if (count > reader.getRemaining() / std::max<size_t>(sizeof(Element), 1)) {
+					throw std::runtime_error("archive is truncated");
+				}
+				value.resize(static_cast<size_t>(count));
+				const char* data = reader.read(value.size() * sizeof(Element));
+				if (count) {
+					std::memcpy(value.data(), data, value.size() * sizeof(Element));
+				}
+			}
+			else {
+				// Not reserved up front, a corrupt count shouldn't turn into a huge allocation
+				for (uint64_t i = 0; i < count; i++) {
+					teReadField(reader, value.emplace_back());
+				}
+			}
+		}
+		else {
+			std::memcpy(&value, reader.read(sizeof(M)), sizeof(M));
+		}
+	}
+
+	template<typename T>
+	void teWriteFields(TeArchiveWriter& writer, const T& object) {
+		if constexpr (teFieldsArePacked<T>) {
+			writer.write(&object, sizeof(T));
+		}
+		else {
+			teForEachField<T>([&](const auto& field) { teWriteField(writer, object.*field.member); });
+		}
+	}
+
+	template<typename T>
+	void teReadFields(TeArchiveReader& reader, T& object) {
+		if constexpr (teFieldsArePacked<T>) {
+			std::memcpy(&object, reader.read(sizeof(T)), sizeof(T));
+		}
+		else {
+			teForEachField<T>([&](const auto& field) { teReadField(reader, object.*field.member); });
+		}
+	}
+
+	// How a registered component is written to and read from archives. Components opt in with
+	//   static void serialize(const T& component, TeArchiveWriter& writer);
+	//   static void deserialize(T& component, TeArchiveReader& reader);
+	// or by listing their fields, see teFields. Either way reading starts from a default constructed
+	// T. Components with only the older
+	//   static std::vector<char> serialize(void*) / static void* deserialize(std::vector<char>)
+	// go through those, and trivially copyable components without any are copied as raw bytes.
+	// Readers are limited to the bytes the component wrote
+	struct TeArchiveFuncs {
+		void (*write)(const void* component, TeArchiveWriter& writer) = nullptr;
+		// Constructs the component in storage
+		void (*read)(void* storage, TeArchiveReader& reader) = nullptr;
+
+		template<typename T>
+		static TeArchiveFuncs of();
+	};
+
+	template<typename T>
+	TeArchiveFuncs TeArchiveFuncs::of() {
+		TeArchiveFuncs funcs{};
+		if constexpr (TeHasArchiveSerialize<T>::value || TeHasFields<T>::value) {
+			funcs.write = [](const void* component, TeArchiveWriter& writer) { teWriteField(writer, *static_cast<const T*>(component)); };
+			funcs.read = [](void* storage, TeArchiveReader& reader) {
+				T* component = new (storage) T();
+				try {
+					teReadField(reader, *component);
+				}
+				catch (...) {
+					component->~T();
+					throw;
+				}
+			};
+		}
+		else if constexpr (TeHasVectorSerialize<T>::value) {
+			funcs.write = [](const void* component, TeArchiveWriter& writer) {
+				std::vector<char> data = T::serialize(const_cast<void*>(component));
+				writer.write(data.data(), data.size());
+			};
+			funcs.read = [](void* storage, TeArchiveReader& reader) {
+				size_t size = reader.getRemaining();
+				const char* data = reader.read(size);
+				T* component = static_cast<T*>(T::deserialize(std::vector<char>(data, data + size)));
+				new (storage) T(std::move(*component));
+				delete component;
+			};
+		}
+		else if constexpr (std::is_trivially_copyable_v<T>) {
+			funcs.write = [](const void* component, TeArchiveWriter& writer) { writer.write(component, sizeof(T)); };
+			funcs.read = [](void* storage, TeArchiveReader& reader) { std::memcpy(storage, reader.read(sizeof(T)), sizeof(T)); };
+		}
+		return funcs;
+	}
+
+	// Components of one type read out of an archive ahead of being moved into a scene, so a
+	// malformed archive throws before the scene is touched. One allocation holds all of them
+	class TeComponentArray {
+	public:
+		TeComponentArray(const TeComponentInfo& info, size_t capacity);
+		~TeComponentArray();
+
+		TeComponentArray(const TeComponentArray&) = delete;
+		TeComponentArray& operator=(const TeComponentArray&) = delete;
+
+		// Constructs the next component from the reader
+		void read(void (*readFunc)(void*, TeArchiveReader&), TeArchiveReader& reader);
+
+		void* get(size_t i) { return data_ + i * info_.size; }
+		size_t size() const { return count_; }
+		const TeComponentInfo& getInfo() const { return info_; }
+	private:
+		TeComponentInfo info_;
+		char* data_;
+		size_t capacity_;
+		size_t count_ = 0;
+	};
+}
@@ -0,0 +1,93 @@
+#include "te_async_loader.hpp"
+#include "te_compression.hpp"
+#include "te_file.hpp"
+
+#include <stdexcept>
+
+namespace te {
+	TeAsyncLoader::TeAsyncLoader(TeECS& manager, size_t threadCount) : manager{ manager }, workers{ threadCount } {}
+
+	TeAsyncLoader::~TeAsyncLoader() {
+		std::unique_lock<std::mutex> lock(loaderMutex);
+		idleCondition.wait(lock, [this] { return running == 0; });
+	}
+
+	void TeAsyncLoader::submit(std::function<void()> task) {
+		loaderMutex.lock();
+		running++;
+		loaderMutex.unlock();
+		workers.submit([this, task = std::move(task)] {
+			task();
+			// Notified under the lock, the destructor may return as soon as it sees running reach zero
+			std::lock_guard<std::mutex> lock(loaderMutex);
+			running--;
+			idleCondition.notify_all();
+		});
+	}
+
+	std::future<TeAsyncLoader::Entity> TeAsyncLoader::loadEntity(std::string path) {
+		auto promise = std::make_shared<std::promise<Entity>>();
+		std::future<Entity> future = promise->get_future();
+		pending++;
+		submit([this, promise, path = std::move(path)] {
+			LoadedEntity loaded;
+			try {
+				std::vector<char> data = TeFile::read(path);
+				if (TeCompression::isCompressed(data)) {
+					data = TeCompression::decompress(data);
+				}
+				TeArchiveReader reader{ data.data(), data.size() };
+				loaded.entity = manager.stageEntity(reader);
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+				pending--;
+				return;
+			}
+			loaded.promise = std::move(*promise);
+			std::lock_guard<std::mutex> lock(loaderMutex);
+			loadedEntities.push_back(std::move(loaded));
+		});
+		return future;
+	}
+
+	size_t TeAsyncLoader::apply(TeScene& scene) {
+		// Checked before anything is taken off the queues, so nothing is lost
+		if (scene.inReadPhase()) {
+			throw std::runtime_error("async loads are applied at the sync point, not inside a read phase");
+		}
+		loaderMutex.lock();
+		if (loadedEntities.empty() && loadedAssets.empty()) {
+			loaderMutex.unlock();
+			return 0;
+		}
+		std::vector<LoadedEntity> entities = std::move(loadedEntities);
+		std::vector<std::function<void()>> assets = std::move(loadedAssets);
+		loadedEntities.clear();
+		loadedAssets.clear();
+		loaderMutex.unlock();
+
+		for (std::function<void()>& finish : assets) {
+			finish();
+		}
+
+		if (!entities.empty()) {
+			std::vector<Entity> pendingEntities;
+			pendingEntities.reserve(entities.size());
+			for (LoadedEntity& loaded : entities) {
+				Entity entity = commands.createEntity(loaded.entity.name);
+				for (auto& component : loaded.entity.components) {
+					commands.addComponent(entity, component->getInfo(), component->get(0));
+				}
+				pendingEntities.push_back(entity);
+			}
+			std::vector<Entity> created = commands.playback(scene);
+			for (size_t i = 0; i < entities.size(); i++) {
+				entities[i].promise.set_value(created[pendingEntities[i].index]);
+			}
+		}
+
+		pending -= entities.size() + assets.size();
+		return entities.size() + assets.size();
+	}
+}
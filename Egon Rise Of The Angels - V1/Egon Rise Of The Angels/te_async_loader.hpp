@@ -0,0 +1,107 @@
+#pragma once
+
+#include "te_ecs.hpp"
+#include "te_entity_command_buffer.hpp"
+#include "te_scheduler.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace te {
+	// Reads and parses entity files and assets on the loader's own threads, so neither the thread
+	// asking for them nor the frame's systems on the shared worker pool ever wait behind the disk.
+	// Finished loads queue up until apply() at a sync point, which adds every loaded entity to the
+	// scene in one batch and finishes the loaded assets. Futures only become ready in the apply()
+	// after their load, failed loads as soon as they fail, so don't wait on one from the thread
+	// that calls apply()
+	class TeAsyncLoader {
+	public:
+		using Entity = TeScene::Entity;
+
+		// Loads mostly wait on the disk, a couple of threads keep it busy without taking cores from the frame
+		static constexpr size_t DEFAULT_THREAD_COUNT = 2;
+
+		TeAsyncLoader(TeECS& manager, size_t threadCount = DEFAULT_THREAD_COUNT);
+
+		// Waits for loads still running, futures of loads that weren't applied break
+		~TeAsyncLoader();
+
+		TeAsyncLoader(const TeAsyncLoader&) = delete;
+		TeAsyncLoader& operator=(const TeAsyncLoader&) = delete;
+
+		// Reads a file written by TeScene::saveEntityToFile, compressed or not
+		std::future<Entity> loadEntity(std::string path);
+
+		// Calls load on a loader thread, then finish with what it returned on the thread calling apply(),
+		// for work that has to happen there like uploading to the GPU
+		template<typename Load, typename Finish>
+		auto loadAsset(Load load, Finish finish) -> std::future<std::invoke_result_t<Finish, std::invoke_result_t<Load>&>>;
+
+		// Call at a sync point. Returns how many loads it completed
+		size_t apply(TeScene& scene);
+
+		// Loads that are still running or waiting for apply()
+		size_t getPendingCount() const { return pending.load(); }
+	private:
+		struct LoadedEntity {
+			std::promise<Entity> promise;
+			TeStagedEntity entity;
+		};
+
+		// Runs the task on a loader thread, keeping the loader alive until it returns
+		void submit(std::function<void()> task);
+
+		TeECS& manager;
+
+		std::mutex loaderMutex;
+		std::condition_variable idleCondition;
+		size_t running = 0;
+		std::vector<LoadedEntity> loadedEntities;
+		std::vector<std::function<void()>> loadedAssets;
+		std::atomic<size_t> pending{ 0 };
+
+		// Only used by apply(), entities are created through it so they're added under one lock
+		TeEntityCommandBuffer commands;
+
+		// Declared last, so its threads are joined before anything they use is destroyed
+		TeWorkerPool workers;
+	};
+
+	template<typename Load, typename Finish>
+	auto TeAsyncLoader::loadAsset(Load load, Finish finish) -> std::future<std::invoke_result_t<Finish, std::invoke_result_t<Load>&>> {
+		using Loaded = std::invoke_result_t<Load>;
+		using Result = std::invoke_result_t<Finish, Loaded&>;
+		auto promise = std::make_shared<std::promise<Result>>();
+		std::future<Result> future = promise->get_future();
+		pending++;
+		submit([this, promise, load = std::move(load), finish = std::move(finish)]() mutable {
+			std::shared_ptr<Loaded> loaded;
+			try {
+				loaded = std::make_shared<Loaded>(load());
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+				pending--;
+				return;
+			}
+			std::lock_guard<std::mutex> lock(loaderMutex);
+			loadedAssets.push_back([promise, loaded, finish = std::move(finish)]() mutable {
+				try {
+					promise->set_value(finish(*loaded));
+				}
+				catch (...) {
+					promise->set_exception(std::current_exception());
+				}
+			});
+		});
+		return future;
+	}
+}
@@ -93,16 +93,41 @@ namespace te {
 
         auto scene = env.scene;
 
-        TransformComponent* playerTransform = scene->getComponent<TransformComponent>(scene->getEntityByName("camera_1"));
+        // Copied under the scene lock, the main thread can move or free rows at the next sync point
+        std::optional<TransformComponent> playerTransform = scene->getComponentCopy<TransformComponent>(scene->getEntityByName("camera_1"));
+        if (!playerTransform) {
+            return "No camera_1 to spawn at";
+        }
+
+        std::optional<ModelComponent> cubeModelComponent = scene->getComponentCopy<ModelComponent>(scene->getEntityByName("cube_1"));
+        if (!cubeModelComponent) {
+            return "No cube_1 to copy the model from";
+        }
+        std::shared_ptr<TeModel> cubeModel = cubeModelComponent->model;
 
-        std::shared_ptr<TeModel> cubeModel = scene->getComponent<ModelComponent>(scene->getEntityByName("cube_1"))->model;
-        auto cube = scene->createEntity(args[0]);
-        scene->addComponent<ModelComponent>(cube, { cubeModel, });
-        scene->addComponent<TransformComponent>(cube, { playerTransform->translation, playerTransform->scale, playerTransform->rotation });
+        // Recorded here on the command thread, applied by the main thread between frames
+        auto cube = env.entityCommands.createEntity(args[0]);
+        env.entityCommands.addComponent<ModelComponent>(cube, { cubeModel, });
+        env.entityCommands.addComponent<TransformComponent>(cube, { playerTransform->translation, playerTransform->scale, playerTransform->rotation });
 
         return "Entity spawned";
     }
 
+    const char* TeCommandThread::command_load(std::vector<std::string> args, TheEngine& env) {
+        if (args.size() != 1) {
+            return "Usage: load <path>";
+        }
+
+        // Read and parsed on a loader thread, the entity shows up at the next sync point without holding up a frame
+        try {
+            env.loader.loadEntity(args[0]).get();
+        }
+        catch (const std::exception&) {
+            return "Couldn't load the entity";
+        }
+        return "Entity loaded";
+    }
+
     const char* TeCommandThread::command_log(std::vector<std::string> args, TheEngine& env) {
         env.logger.log();
         return "";
@@ -25,6 +25,7 @@ namespace te {
 
 		static const char* command_spawn(std::vector<std::string> args, TheEngine& env);
 		static const char* command_log(std::vector<std::string> args, TheEngine& env);
+		static const char* command_load(std::vector<std::string> args, TheEngine& env);
 	private:
 		std::unordered_map<std::string, std::function<const char* (std::vector<std::string>, TheEngine&)>> commands;
 		std::mutex commandsMutex;
@@ -0,0 +1,91 @@
+#include "te_component_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace te {
+	TeComponentPool::TeComponentPool(const TeComponentInfo* component) : component_{ component } {}
+
+	TeComponentPool::~TeComponentPool() {
+		for (size_t i = 0; i < entities_.size(); i++) {
+			component_->destroy(data_ + i * component_->size);
+		}
+		if (!dataOwner_) {
+			::operator delete(data_, std::align_val_t{ std::max(component_->alignment, alignof(std::max_align_t)) });
+		}
+	}
+
+	void TeComponentPool::reserve(size_t capacity) {
+		if (capacity <= capacity_) {
+			return;
+		}
+		size_t alignment = std::max(component_->alignment, alignof(std::max_align_t));
+		char* data = static_cast<char*>(::operator new(capacity * component_->size, std::align_val_t{ alignment }));
+		for (size_t i = 0; i < entities_.size(); i++) {
+			component_->moveConstruct(data + i * component_->size, data_ + i * component_->size);
+			component_->destroy(data_ + i * component_->size);
+		}
+		if (!dataOwner_) {
+			::operator delete(data_, std::align_val_t{ alignment });
+		}
+		dataOwner_.reset();
+		data_ = data;
+		capacity_ = capacity;
+		entities_.reserve(capacity);
+		versions_.reserve(capacity);
+	}
+
+	void TeComponentPool::borrow(char* data, size_t capacity, std::shared_ptr<void> owner) {
+		if (!entities_.empty()) {
+			throw std::runtime_error("only an empty pool can borrow storage");
+		}
+		if (!dataOwner_) {
+			::operator delete(data_, std::align_val_t{ std::max(component_->alignment, alignof(std::max_align_t)) });
+		}
+		dataOwner_ = std::move(owner);
+		data_ = data;
+		capacity_ = capacity;
+		entities_.reserve(capacity);
+		versions_.reserve(capacity);
+	}
+
+	void* TeComponentPool::allocate(TeEntity entity) {
+		if (entity.index >= sparse_.size()) {
+			sparse_.resize(static_cast<size_t>(entity.index) + 1, EMPTY);
+		}
+		if (entities_.size() == capacity_) {
+			reserve(std::max<size_t>(capacity_ * 2, 64));
+		}
+		return data_ + entities_.size() * component_->size;
+	}
+
+	void TeComponentPool::commit(TeEntity entity) {
+		// allocate made room for both, so nothing here can throw
+		sparse_[entity.index] = static_cast<uint32_t>(entities_.size());
+		entities_.push_back(entity);
+		versions_.push_back(0);
+	}
+
+	void TeComponentPool::remove(TeEntity entity) {
+		void* component = get(entity);
+		if (!component) {
+			return;
+		}
+		component_->destroy(component);
+
+		// Keep the dense array packed by moving the last component into the hole
+		uint32_t dense = sparse_[entity.index];
+		uint32_t last = static_cast<uint32_t>(entities_.size() - 1);
+		if (dense != last) {
+			void* src = data_ + last * component_->size;
+			component_->moveConstruct(component, src);
+			component_->destroy(src);
+			entities_[dense] = entities_[last];
+			versions_[dense] = versions_[last];
+			sparse_[entities_[dense].index] = dense;
+		}
+		entities_.pop_back();
+		versions_.pop_back();
+		sparse_[entity.index] = EMPTY;
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "te_archetype.hpp"
+
+#include <memory>
+
+namespace te {
+	// Sparse set storage for a single component type: components are packed in a dense
+	// array and a sparse array maps entity indices into it, so add, remove and lookup
+	// are O(1) and iteration is linear over the dense array
+	class TeComponentPool {
+	public:
+		TeComponentPool(const TeComponentInfo* component);
+		~TeComponentPool();
+
+		TeComponentPool(const TeComponentPool&) = delete;
+		TeComponentPool& operator=(const TeComponentPool&) = delete;
+
+		void* get(TeEntity entity) {
+			if (entity.index >= sparse_.size() || sparse_[entity.index] == EMPTY) {
+				return nullptr;
+			}
+			uint32_t dense = sparse_[entity.index];
+			return entities_[dense] == entity ? data_ + dense * component_->size : nullptr;
+		}
+
+		bool contains(TeEntity entity) { return get(entity) != nullptr; }
+
+		// Returns unconstructed storage for a component of an entity that doesn't have one yet. The
+		// entity only gets it once commit is called, after the component is constructed there, so a
+		// constructor that throws leaves the pool as it was. Growing the pool moves its components
+		void* allocate(TeEntity entity);
+
+		void commit(TeEntity entity);
+
+		void remove(TeEntity entity);
+
+		// Grows the dense storage to hold at least capacity components without reallocating
+		void reserve(size_t capacity);
+
+		// Makes an empty pool use data, owned by owner, as its dense storage, so components can be
+		// emplaced in place over bytes that are already there. The pool switches to its own
+		// storage the first time it has to grow
+		void borrow(char* data, size_t capacity, std::shared_ptr<void> owner);
+
+		// Stamps the component with a change version, the entity must have the component
+		void markChanged(TeEntity entity, uint32_t version) { versions_[sparse_[entity.index]] = version; }
+
+		size_t size() const { return entities_.size(); }
+		size_t capacity() const { return capacity_; }
+		const TeEntity* getEntities() const { return entities_.data(); }
+		const uint32_t* getVersions() const { return versions_.data(); }
+		char* getData() { return data_; }
+		const TeComponentInfo* getComponentInfo() const { return component_; }
+	private:
+		static constexpr uint32_t EMPTY = UINT32_MAX;
+
+		const TeComponentInfo* component_;
+
+		std::vector<uint32_t> sparse_;
+		std::vector<TeEntity> entities_;
+		std::vector<uint32_t> versions_;
+		char* data_ = nullptr;
+		size_t capacity_ = 0;
+
+		// Set while data_ is borrowed rather than allocated by the pool
+		std::shared_ptr<void> dataOwner_;
+	};
+}
@@ -0,0 +1,218 @@
+#include "te_compression.hpp"
+#include "te_scheduler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace te {
+	namespace {
+		constexpr size_t MIN_MATCH = 4;
+		constexpr size_t MAX_OFFSET = 65535;
+		constexpr int HASH_BITS = 14;
+
+		uint32_t read32(const char* data) {
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		uint32_t hash(uint32_t sequence) {
+			return (sequence * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		// Lengths that don't fit in their nibble continue in bytes of 255 and a final smaller one
+		void writeLength(std::vector<char>& output, size_t length) {
+			for (; length >= 255; length -= 255) {
+				output.push_back(static_cast<char>(255));
+			}
+			output.push_back(static_cast<char>(length));
+		}
+
+		void writeSequence(std::vector<char>& output, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+			size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+			output.push_back(static_cast<char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+			if (literalLength >= 15) {
+				writeLength(output, literalLength - 15);
+			}
+			output.insert(output.end(), literals, literals + literalLength);
+			if (!matchLength) {
+				return;
+			}
+			output.push_back(static_cast<char>(offset & 0xff));
+			output.push_back(static_cast<char>(offset >> 8));
+			if (matchCode >= 15) {
+				writeLength(output, matchCode - 15);
+			}
+		}
+
+		size_t readLength(TeArchiveReader& reader, size_t length) {
+			if (length != 15) {
+				return length;
+			}
+			uint8_t byte;
+			do {
+				byte = reader.read<uint8_t>();
+				length += byte;
+			} while (byte == 255);
+			return length;
+		}
+	}
+
+	bool TeCompression::compressBlock(const char* data, size_t size, std::vector<char>& output) {
+		size_t start = output.size();
+		// Positions plus one, so zero means empty
+		std::vector<uint32_t> table(size_t(1) << HASH_BITS);
+		size_t anchor = 0;
+		size_t position = 0;
+		while (position + MIN_MATCH <= size) {
+			if (output.size() - start >= size) {
+				return false;
+			}
+			uint32_t sequence = read32(data + position);
+			uint32_t& entry = table[hash(sequence)];
+			size_t candidate = entry;
+			entry = static_cast<uint32_t>(position + 1);
+			if (!candidate || position + 1 - candidate > MAX_OFFSET || read32(data + candidate - 1) != sequence) {
+				// Skips ahead faster the longer nothing matches, so incompressible data goes quickly
+				position += 1 + ((position - anchor) >> 6);
+				continue;
+			}
+			candidate--;
+			size_t length = MIN_MATCH;
+			while (position + length < size && data[candidate + length] == data[position + length]) {
+				length++;
+			}
+			writeSequence(output, data + anchor, position - anchor, position - candidate, length);
+			position += length;
+			anchor = position;
+		}
+		writeSequence(output, data + anchor, size - anchor, 0, 0);
+		return output.size() - start < size;
+	}
+
+	void TeCompression::decompressBlock(const char* data, size_t size, char* output, size_t outputSize) {
+		TeArchiveReader reader{ data, size };
+		size_t written = 0;
+		while (true) {
+			uint8_t token = reader.read<uint8_t>();
+			size_t literalLength = readLength(reader, token >> 4);
+			if (literalLength > outputSize - written) {
+				throw std::runtime_error("compressed block is corrupt");
+			}
+			std::memcpy(output + written, reader.read(literalLength), literalLength);
+			written += literalLength;
+			if (reader.isEmpty()) {
+				break;
+			}
+
+			size_t offset = reader.read<uint8_t>();
+			offset |= static_cast<size_t>(reader.read<uint8_t>()) << 8;
+			size_t matchLength = readLength(reader, token & 15) + MIN_MATCH;
+			if (offset == 0 || offset > written || matchLength > outputSize - written) {
+				throw std::runtime_error("compressed block is corrupt");
+			}
+			// Matches may overlap what they produce, which repeats the last offset bytes
+			char* target = output + written;
+			const char* source = target - offset;
+			if (offset >= matchLength) {
+				std::memcpy(target, source, matchLength);
+			}
+			else {
+				for (size_t i = 0; i < matchLength; i++) {
+					target[i] = source[i];
+				}
+			}
+			written += matchLength;
+		}
+		if (written != outputSize) {
+			throw std::runtime_error("compressed block is corrupt");
+		}
+	}
+
+	void TeCompression::compress(const char* data, size_t size, TeArchiveWriter& writer, TeWorkerPool* workers) {
+		TeCompressedHeader header{};
+		header.size = size;
+		header.blockSize = BLOCK_SIZE;
+		header.blockCount = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		size_t blockCount = static_cast<size_t>(header.blockCount);
+
+		// Empty where the block didn't compress and is stored as is
+		std::vector<std::vector<char>> blocks(blockCount);
+		TeWorkerPool::forEach(workers, blockCount, [&](size_t b) {
+			size_t blockSize = std::min(BLOCK_SIZE, size - b * BLOCK_SIZE);
+			blocks[b].reserve(blockSize);
+			if (!compressBlock(data + b * BLOCK_SIZE, blockSize, blocks[b])) {
+				std::vector<char>().swap(blocks[b]);
+			}
+		});
+
+		writer.write(header);
+		for (size_t b = 0; b < blockCount; b++) {
+			writer.write(static_cast<uint32_t>(blocks[b].empty() ? std::min(BLOCK_SIZE, size - b * BLOCK_SIZE) : blocks[b].size()));
+		}
+		for (size_t b = 0; b < blockCount; b++) {
+			if (blocks[b].empty()) {
+				writer.write(data + b * BLOCK_SIZE, std::min(BLOCK_SIZE, size - b * BLOCK_SIZE));
+			}
+			else {
+				writer.write(blocks[b].data(), blocks[b].size());
+			}
+		}
+	}
+
+	std::vector<char> TeCompression::compress(const std::vector<char>& data, TeWorkerPool* workers) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		compress(data.data(), data.size(), writer, workers);
+		return output;
+	}
+
+	std::vector<char> TeCompression::decompress(const char* data, size_t size, TeWorkerPool* workers) {
+		TeArchiveReader reader{ data, size };
+		TeCompressedHeader header = reader.read<TeCompressedHeader>();
+		if (header.magic != TeCompressedHeader::MAGIC || header.version != TeCompressedHeader::VERSION) {
+			throw std::runtime_error("not compressed data or compressed by an unsupported version");
+		}
+		if (header.blockSize == 0 || header.blockSize > UINT32_MAX || header.blockCount > size / sizeof(uint32_t)
+			|| header.blockCount != (header.size + header.blockSize - 1) / header.blockSize || header.size / 256 > size) {
+			throw std::runtime_error("compressed data is corrupt");
+		}
+		size_t blockCount = static_cast<size_t>(header.blockCount);
+		size_t blockSize = static_cast<size_t>(header.blockSize);
+
+		struct Block {
+			const char* data;
+			size_t size;
+		};
+		std::vector<Block> blocks(blockCount);
+		const char* sizes = reader.read(blockCount * sizeof(uint32_t));
+		for (size_t b = 0; b < blockCount; b++) {
+			blocks[b].size = read32(sizes + b * sizeof(uint32_t));
+		}
+		for (Block& block : blocks) {
+			block.data = reader.read(block.size);
+		}
+
+		std::vector<char> output(static_cast<size_t>(header.size));
+		TeWorkerPool::forEach(workers, blockCount, [&](size_t b) {
+			size_t outputSize = std::min(blockSize, output.size() - b * blockSize);
+			char* target = output.data() + b * blockSize;
+			if (blocks[b].size == outputSize) {
+				std::memcpy(target, blocks[b].data, outputSize);
+				return;
+			}
+			decompressBlock(blocks[b].data, blocks[b].size, target, outputSize);
+		});
+		return output;
+	}
+
+	bool TeCompression::isCompressed(const char* data, size_t size) {
+		uint32_t magic;
+		if (size < sizeof(TeCompressedHeader)) {
+			return false;
+		}
+		std::memcpy(&magic, data, sizeof(magic));
+		return magic == TeCompressedHeader::MAGIC;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "te_archive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace te {
+	class TeWorkerPool;
+
+	// Layout of data compressed by TeCompression:
+	//   TeCompressedHeader
+	//   a uint32_t compressed size per block
+	//   the blocks back to back
+	// Every block but the last holds blockSize bytes of the original data and decompresses without
+	// the others. A block whose compressed size equals its original size is stored as is
+	struct TeCompressedHeader {
+		static constexpr uint32_t MAGIC = 0x5a4c4554; // "TELZ"
+		static constexpr uint32_t VERSION = 1;
+
+		uint32_t magic = MAGIC;
+		uint32_t version = VERSION;
+		uint64_t size = 0;
+		uint64_t blockSize = 0;
+		uint64_t blockCount = 0;
+	};
+
+	// LZ77 block codec in the style of LZ4, byte oriented and fast to decode rather than small.
+	// Blocks are compressed and decompressed in parallel when given workers
+	class TeCompression {
+	public:
+		static constexpr size_t BLOCK_SIZE = 256 * 1024;
+
+		static void compress(const char* data, size_t size, TeArchiveWriter& writer, TeWorkerPool* workers = nullptr);
+
+		static std::vector<char> compress(const std::vector<char>& data, TeWorkerPool* workers = nullptr);
+
+		// Throws if the data is malformed
+		static std::vector<char> decompress(const char* data, size_t size, TeWorkerPool* workers = nullptr);
+
+		static std::vector<char> decompress(const std::vector<char>& data, TeWorkerPool* workers = nullptr) { return decompress(data.data(), data.size(), workers); }
+
+		static bool isCompressed(const char* data, size_t size);
+
+		static bool isCompressed(const std::vector<char>& data) { return isCompressed(data.data(), data.size()); }
+	private:
+		// Appends the compressed block to output, returns false once it would come out no smaller
+		static bool compressBlock(const char* data, size_t size, std::vector<char>& output);
+
+		static void decompressBlock(const char* data, size_t size, char* output, size_t outputSize);
+	};
+}
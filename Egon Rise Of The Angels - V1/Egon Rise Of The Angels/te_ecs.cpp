@@ -0,0 +1,833 @@
+#include "te_compression.hpp"
+#include "te_ecs.hpp"
+#include "te_file.hpp"
+#include "te_prefab.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace te {
+    TeScene::TeScene(TeECS& manager) : manager(manager) {
+        auto empty = std::make_unique<TeArchetype>(std::vector<const TeComponentInfo*>{}, chunkAllocator);
+        emptyArchetype = empty.get();
+        archetypes[{}] = std::move(empty);
+    }
+
+    TeScene::~TeScene() {
+        detachCaptureNOLOCK();
+    }
+
+    thread_local const TeScene* TeScene::readPhaseScene = nullptr;
+
+    thread_local const std::vector<TeComponentTypeId>* TeWriteAccess::current = nullptr;
+
+    std::shared_lock<std::shared_mutex> TeScene::lockForRead() {
+        if (inReadPhase()) {
+            return std::shared_lock<std::shared_mutex>();
+        }
+        return std::shared_lock<std::shared_mutex>(sceneMutex);
+    }
+
+    void TeScene::lockForWrite() {
+        if (inReadPhase()) {
+            throw std::runtime_error("structural scene change inside a read phase, defer it to the sync point");
+        }
+        sceneMutex.lock();
+        // A capture nobody else holds will never be saved, otherwise it only needs the entity table
+        // now, each chunk or pool is preserved as the change gets to it
+        try {
+            if (activeCapture && activeCapture.use_count() == 1) {
+                detachCaptureNOLOCK();
+            }
+            else if (capturing.load()) {
+                preserveEntitiesForCaptureNOLOCK();
+            }
+        }
+        catch (...) {
+            sceneMutex.unlock();
+            throw;
+        }
+    }
+
+    TeReadPhase::TeReadPhase(TeScene& scene, bool lockScene) : scene{ scene }, previousScene{ TeScene::readPhaseScene } {
+        if (lockScene && !scene.inReadPhase()) {
+            lock = std::shared_lock<std::shared_mutex>(scene.sceneMutex);
+        }
+        TeScene::readPhaseScene = &scene;
+    }
+
+    TeReadPhase::~TeReadPhase() {
+        TeScene::readPhaseScene = previousScene;
+    }
+
+    TeScene::EntityRecord* TeScene::getRecordNOLOCK(Entity entity) {
+        if (entity.index >= entityRecords.size()) {
+            return nullptr;
+        }
+        EntityRecord& record = entityRecords[entity.index];
+        return record.archetype && record.generation == entity.generation ? &record : nullptr;
+    }
+
+    TeScene::Entity TeScene::allocateEntityNOLOCK() {
+        Entity entity{};
+        if (!freeEntityIndices.empty()) {
+            entity.index = freeEntityIndices.back();
+            freeEntityIndices.pop_back();
+        }
+        else {
+            entity.index = static_cast<uint32_t>(entityRecords.size());
+            entityRecords.emplace_back();
+            entityNames.push_back(TeNameTable::NONE);
+        }
+        entity.generation = entityRecords[entity.index].generation;
+        return entity;
+    }
+
+    // Create entity
+    TeScene::Entity TeScene::createEntity(std::string_view name) {
+        // Interned before locking, the name table has its own lock
+        TeName nameId = manager.getNameTable().intern(name);
+        lockForWrite();
+        Entity entity = createEntityNOLOCK(nameId);
+        sceneMutex.unlock();
+        return entity;
+    }
+
+    TeScene::Entity TeScene::createEntityNOLOCK(TeName name) {
+        Entity entity = allocateEntityNOLOCK();
+        setEntityNameNOLOCK(entity, name);
+        EntityRecord& record = entityRecords[entity.index];
+        record.archetype = emptyArchetype;
+        record.location = emptyArchetype->allocateRow(entity);
+        if (logging) {
+            printf("Created entity %s\n", manager.getNameTable().getString(name).c_str());
+        }
+        return entity;
+    }
+
+    void TeScene::setEntityNameNOLOCK(Entity entity, TeName name) {
+        entityNames[entity.index] = name;
+        if (name == TeNameTable::NONE) {
+            return;
+        }
+        if (name >= namesToEntities.size()) {
+            namesToEntities.resize(static_cast<size_t>(name) + 1);
+        }
+        namesToEntities[name] = entity;
+    }
+
+    TeScene::Entity TeScene::duplicateEntity(TeScene::Entity entity, std::string_view newName) {
+        TeName nameId = manager.getNameTable().intern(newName);
+        lockForWrite();
+        if (!getRecordNOLOCK(entity) || !isCopyableNOLOCK(entity)) {
+			sceneMutex.unlock();
+			return {};
+		}
+		Entity newEntity{};
+        copyEntityNOLOCK(entity, &newEntity, 1);
+        
+        setEntityNameNOLOCK(newEntity, nameId);
+        if (logging) {
+            std::cout << newName << std::endl;
+        }
+
+		sceneMutex.unlock();
+		return newEntity;
+    }
+
+    std::vector<TeScene::Entity> TeScene::createEntities(size_t count, Entity prototype) {
+        lockForWrite();
+        if (!prototype.isNull() && (!getRecordNOLOCK(prototype) || !isCopyableNOLOCK(prototype))) {
+            sceneMutex.unlock();
+            throw std::runtime_error("prototype entity is stale or has a component that can't be copied");
+        }
+        std::vector<Entity> output(count);
+        if (prototype.isNull()) {
+            reserveEntitiesNOLOCK(count);
+            for (size_t i = 0; i < count; i++) {
+                output[i] = allocateEntityNOLOCK();
+                EntityRecord& record = entityRecords[output[i].index];
+                record.archetype = emptyArchetype;
+                record.location = emptyArchetype->allocateRow(output[i]);
+            }
+        }
+        else {
+            copyEntityNOLOCK(prototype, output.data(), count);
+        }
+        if (logging) {
+            printf("Created %zu entities\n", count);
+        }
+        sceneMutex.unlock();
+        return output;
+    }
+
+    void TeScene::destroyEntities(const Entity* entities, size_t count) {
+        lockForWrite();
+        freeEntityIndices.reserve(freeEntityIndices.size() + count);
+        for (size_t i = 0; i < count; i++) {
+            destroyEntityNOLOCK(entities[i]);
+        }
+        sceneMutex.unlock();
+    }
+
+    void TeScene::reserveEntitiesNOLOCK(size_t count) {
+        size_t needed = count > freeEntityIndices.size() ? count - freeEntityIndices.size() : 0;
+        entityRecords.reserve(entityRecords.size() + needed);
+        entityNames.reserve(entityNames.size() + needed);
+    }
+
+    bool TeScene::isCopyableNOLOCK(Entity entity) {
+        for (auto* component : entityRecords[entity.index].archetype->getComponents()) {
+            if (!component->copyConstruct) return false;
+        }
+        for (auto& componentType : componentTypes) {
+            if (componentType && componentType->pool && !componentType->info.copyConstruct && componentType->pool->contains(entity)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TeScene::copyEntityNOLOCK(Entity prototype, Entity* output, size_t count) {
+        // Appending rows never moves existing ones, so the prototype's components stay put while
+        // the copies are made. Pools are grown up front since that does move their components
+        std::vector<std::pair<const TeComponentInfo*, const void*>> components;
+        EntityRecord& record = entityRecords[prototype.index];
+        for (size_t column = 0; column < record.archetype->getComponents().size(); column++) {
+            components.emplace_back(record.archetype->getComponents()[column], record.archetype->getComponent(record.location, column));
+        }
+        for (auto& componentType : componentTypes) {
+            TeComponentPool* pool = componentType ? componentType->pool.get() : nullptr;
+            if (pool && pool->contains(prototype)) {
+                preparePoolReserveNOLOCK(pool, pool->size() + count);
+                pool->reserve(pool->size() + count);
+                components.emplace_back(&componentType->info, pool->get(prototype));
+            }
+        }
+        createCopiesNOLOCK(components, output, count);
+    }
+
+    void TeScene::createCopiesNOLOCK(const std::vector<std::pair<const TeComponentInfo*, const void*>>& components, Entity* output, size_t count) {
+        reserveEntitiesNOLOCK(count);
+
+        std::vector<const TeComponentInfo*> archetypeComponents;
+        for (auto& [info, original] : components) {
+            if (info->storage == TeStoragePolicy::Archetype) {
+                archetypeComponents.push_back(info);
+            }
+        }
+        TeArchetype* archetype = getArchetypeNOLOCK(archetypeComponents);
+        std::vector<TeArchetype::Location> locations(count);
+        for (size_t i = 0; i < count; i++) {
+            output[i] = allocateEntityNOLOCK();
+            locations[i] = archetype->allocateRow(output[i]);
+            entityRecords[output[i].index].archetype = archetype;
+            entityRecords[output[i].index].location = locations[i];
+        }
+
+        // Component at a time, so each pass streams through one column or pool
+        uint32_t version = getChangeVersion();
+        for (auto& [info, original] : components) {
+            if (info->storage == TeStoragePolicy::Archetype) {
+                int column = archetype->getColumn(info->id);
+                for (size_t i = 0; i < count; i++) {
+                    info->copyConstruct(archetype->getComponent(locations[i], column), original);
+                    archetype->markChanged(locations[i], column, version);
+                }
+            }
+            else {
+                TeComponentPool* pool = componentTypes[info->id]->pool.get();
+                preparePoolReserveNOLOCK(pool, pool->size() + count);
+                pool->reserve(pool->size() + count);
+                for (size_t i = 0; i < count; i++) {
+                    info->copyConstruct(pool->allocate(output[i]), original);
+                    pool->commit(output[i]);
+                    pool->markChanged(output[i], version);
+                }
+            }
+        }
+    }
+
+    std::vector<TeScene::Entity> TeScene::instantiate(const TePrefab& prefab, size_t count) {
+        lockForWrite();
+        std::vector<std::pair<const TeComponentInfo*, const void*>> components;
+        for (auto& component : prefab.components) {
+            components.emplace_back(getComponentInfoNOLOCK(component.info), component.data);
+        }
+        std::vector<Entity> output(count);
+        createCopiesNOLOCK(components, output.data(), count);
+        if (logging) {
+            printf("Instantiated %zu entities\n", count);
+        }
+        sceneMutex.unlock();
+        return output;
+    }
+
+    std::unique_ptr<TePrefab> TeScene::createPrefab(Entity entity) {
+        std::shared_lock<std::shared_mutex> lock = lockForRead();
+        EntityRecord* record = getRecordNOLOCK(entity);
+        if (!record) {
+            return nullptr;
+        }
+        auto prefab = std::make_unique<TePrefab>();
+        for (size_t column = 0; column < record->archetype->getComponents().size(); column++) {
+            prefab->addCopy(*record->archetype->getComponents()[column], record->archetype->getComponent(record->location, column));
+        }
+        for (auto& componentType : componentTypes) {
+            if (componentType && componentType->pool && componentType->pool->contains(entity)) {
+                prefab->addCopy(componentType->info, componentType->pool->get(entity));
+            }
+        }
+        return prefab;
+    }
+
+    // Destroy entity
+    void TeScene::destroyEntity(TeScene::Entity& entity) {
+        lockForWrite();
+        destroyEntityNOLOCK(entity);
+        sceneMutex.unlock();
+    }
+
+    void TeScene::destroyEntityNOLOCK(Entity entity) {
+        EntityRecord* record = getRecordNOLOCK(entity);
+        if (!record) {
+            return;
+        }
+        // Clean up components
+        prepareRemoveRowNOLOCK(record->archetype, record->location);
+        record->archetype->destroyRow(record->location);
+        Entity moved = record->archetype->removeRow(record->location);
+        if (moved != entity) {
+            entityRecords[moved.index].location = record->location;
+        }
+        for (auto& componentType : componentTypes) {
+            if (componentType && componentType->pool && componentType->pool->contains(entity)) {
+                preparePoolRemoveNOLOCK(componentType->pool.get(), entity);
+                componentType->pool->remove(entity);
+            }
+        }
+
+        // Free the slot, bumping the generation invalidates every outstanding handle to it
+        record->archetype = nullptr;
+        record->generation++;
+        freeEntityIndices.push_back(entity.index);
+
+        TeName name = entityNames[entity.index];
+        if (name != TeNameTable::NONE && namesToEntities[name] == entity) {
+            namesToEntities[name] = {};
+        }
+        entityNames[entity.index] = TeNameTable::NONE;
+    }
+
+    bool TeScene::isAlive(TeScene::Entity entity) {
+        std::shared_lock<std::shared_mutex> lock = lockForRead();
+        return getRecordNOLOCK(entity) != nullptr;
+    }
+
+    std::vector<TeScene::Entity> TeScene::getEntities() {
+        std::shared_lock<std::shared_mutex> lock = lockForRead();
+        std::vector<Entity> output;
+        for (uint32_t index = 0; index < entityRecords.size(); index++) {
+            if (entityRecords[index].archetype) {
+                output.push_back({ index, entityRecords[index].generation });
+            }
+        }
+        return output;
+    }
+
+    const TeComponentInfo* TeScene::getComponentInfoNOLOCK(const TeComponentInfo& info) {
+        if (info.id >= componentTypes.size()) {
+            componentTypes.resize(info.id + 1);
+        }
+        auto& componentType = componentTypes[info.id];
+        if (!componentType) {
+            componentType = std::make_unique<ComponentType>();
+            componentType->info = info;
+            // The storage policy is fixed by registration, scenes can't disagree about it
+            if (manager.isRegisteredNOLOCK(info.id)) {
+                componentType->info.storage = manager.getRegisteredComponents()[manager.typeToComponentId(info.id)].componentInfo.storage;
+            }
+            if (componentType->info.storage == TeStoragePolicy::SparseSet) {
+                componentType->pool = std::make_unique<TeComponentPool>(&componentType->info);
+            }
+        }
+        return &componentType->info;
+    }
+
+    void TeScene::removeComponentNOLOCK(Entity entity, TeComponentTypeId type) {
+        EntityRecord* record = getRecordNOLOCK(entity);
+        if (!record) {
+            return;
+        }
+        if (record->archetype->getColumn(type) != -1) {
+            moveEntityNOLOCK(entity, getArchetypeWithoutNOLOCK(record->archetype, type));
+        }
+        else if (TeComponentPool* pool = getPoolNOLOCK(type)) {
+            if (pool->contains(entity)) {
+                preparePoolRemoveNOLOCK(pool, entity);
+                pool->remove(entity);
+            }
+        }
+    }
+
+    void TeScene::preparePoolEmplaceNOLOCK(TeComponentPool* pool, Entity entity) {
+        if (!capturing.load()) {
+            return;
+        }
+        if (char* existing = static_cast<char*>(pool->get(entity))) {
+            prepareWriteNOLOCK(pool, (existing - pool->getData()) / pool->getComponentInfo()->size);
+        }
+        else if (pool->size() == pool->capacity()) {
+            prepareWriteNOLOCK(pool);
+        }
+    }
+
+    void TeScene::preparePoolRemoveNOLOCK(TeComponentPool* pool, Entity entity) {
+        // The last component is moved into the hole
+        if (char* component = static_cast<char*>(pool->get(entity)); component && capturing.load()) {
+            prepareWriteNOLOCK(pool, (component - pool->getData()) / pool->getComponentInfo()->size);
+            prepareWriteNOLOCK(pool, pool->size() - 1);
+        }
+    }
+
+    TeArchetype* TeScene::getArchetypeNOLOCK(std::vector<const TeComponentInfo*> components) {
+        std::sort(components.begin(), components.end(), [](const TeComponentInfo* a, const TeComponentInfo* b) { return a->id < b->id; });
+        std::vector<TeComponentTypeId> signature;
+        signature.reserve(components.size());
+        for (auto* component : components) {
+            signature.push_back(component->id);
+        }
+
+        auto& archetype = archetypes[signature];
+        if (!archetype) {
+            archetype = std::make_unique<TeArchetype>(std::move(components), chunkAllocator);
+        }
+        return archetype.get();
+    }
+
+    static void setEdge(std::vector<TeArchetype*>& edges, TeComponentTypeId id, TeArchetype* target) {
+        if (id >= edges.size()) {
+            edges.resize(id + 1, nullptr);
+        }
+        edges[id] = target;
+    }
+
+    TeArchetype* TeScene::getArchetypeWithNOLOCK(TeArchetype* archetype, const TeComponentInfo* component) {
+        if (component->id < archetype->addEdges.size() && archetype->addEdges[component->id]) {
+            return archetype->addEdges[component->id];
+        }
+        std::vector<const TeComponentInfo*> components = archetype->getComponents();
+        components.push_back(component);
+        TeArchetype* target = getArchetypeNOLOCK(std::move(components));
+        setEdge(archetype->addEdges, component->id, target);
+        setEdge(target->removeEdges, component->id, archetype);
+        return target;
+    }
+
+    TeArchetype* TeScene::getArchetypeWithoutNOLOCK(TeArchetype* archetype, TeComponentTypeId id) {
+        if (id < archetype->removeEdges.size() && archetype->removeEdges[id]) {
+            return archetype->removeEdges[id];
+        }
+        std::vector<const TeComponentInfo*> components;
+        for (auto* component : archetype->getComponents()) {
+            if (component->id != id) {
+                components.push_back(component);
+            }
+        }
+        TeArchetype* target = getArchetypeNOLOCK(std::move(components));
+        setEdge(archetype->removeEdges, id, target);
+        setEdge(target->addEdges, id, archetype);
+        return target;
+    }
+
+    void TeScene::moveEntityNOLOCK(Entity entity, TeArchetype* target, TeArchetype::Location to) {
+        EntityRecord& record = entityRecords[entity.index];
+        TeArchetype* source = record.archetype;
+        TeArchetype::Location from = record.location;
+        prepareRemoveRowNOLOCK(source, from);
+
+        // Components the target shares with the source are moved, the rest are dropped
+        auto& components = source->getComponents();
+        for (size_t column = 0; column < components.size(); column++) {
+            void* component = source->getComponent(from, column);
+            int targetColumn = target->getColumn(components[column]->id);
+            if (targetColumn != -1) {
+                components[column]->moveConstruct(target->getComponent(to, targetColumn), component);
+                target->markChanged(to, targetColumn, source->getVersion(from, column));
+            }
+            components[column]->destroy(component);
+        }
+
+        Entity moved = source->removeRow(from);
+        if (moved != entity) {
+            entityRecords[moved.index].location = from;
+        }
+        record.archetype = target;
+        record.location = to;
+    }
+
+    // Assigning leaves the component in place even if it throws
+    static void replaceComponent(const TeComponentInfo* component, void* existing, void* value) {
+        if (component->moveAssign) {
+            component->moveAssign(existing, value);
+            return;
+        }
+        component->destroy(existing);
+        component->moveConstruct(existing, value);
+    }
+
+    void TeScene::setComponentNOLOCK(Entity entity, EntityRecord& record, const TeComponentInfo* component, void* value) {
+        if (component->storage == TeStoragePolicy::SparseSet) {
+            TeComponentPool* pool = componentTypes[component->id]->pool.get();
+            preparePoolEmplaceNOLOCK(pool, entity);
+            if (void* existing = pool->get(entity)) {
+                replaceComponent(component, existing, value);
+            }
+            else {
+                component->moveConstruct(pool->allocate(entity), value);
+                pool->commit(entity);
+            }
+            pool->markChanged(entity, getChangeVersion());
+            return;
+        }
+        int column = record.archetype->getColumn(component->id);
+        prepareWriteNOLOCK(record.archetype->getChunks()[record.location.chunk]);
+        replaceComponent(component, record.archetype->getComponent(record.location, column), value);
+        record.archetype->markChanged(record.location, column, getChangeVersion());
+    }
+
+    bool TeScene::emplaceComponentNOLOCK(Entity entity, const TeComponentInfo* component, void* value) {
+        EntityRecord* record = getRecordNOLOCK(entity);
+        if (!record) {
+            return false;
+        }
+        if (component->storage == TeStoragePolicy::SparseSet || record->archetype->getColumn(component->id) != -1) {
+            setComponentNOLOCK(entity, *record, component, value);
+            return true;
+        }
+
+        // Built in the new row before anything moves, so a throwing move only has the row to undo
+        TeArchetype* target = getArchetypeWithNOLOCK(record->archetype, component);
+        TeArchetype::Location to = target->allocateRow(entity);
+        int column = target->getColumn(component->id);
+        try {
+            component->moveConstruct(target->getComponent(to, column), value);
+        }
+        catch (...) {
+            target->removeRow(to);
+            throw;
+        }
+        moveEntityNOLOCK(entity, target, to);
+        target->markChanged(to, column, getChangeVersion());
+        return true;
+    }
+
+    bool TeScene::emplaceComponentsNOLOCK(Entity entity, const std::vector<const TeComponentInfo*>& components, void* const* values) {
+        EntityRecord* record = getRecordNOLOCK(entity);
+        if (!record) {
+            return false;
+        }
+        TeArchetype* source = record->archetype;
+        TeArchetype* target = source;
+        for (auto* component : components) {
+            if (component->storage == TeStoragePolicy::Archetype && target->getColumn(component->id) == -1) {
+                target = getArchetypeWithNOLOCK(target, component);
+            }
+        }
+
+        // Components the entity gains are built in its new row before anything moves, the first
+        // instance of each type at least, later ones are assigned over it like any existing one
+        std::vector<bool> added(components.size());
+        if (target != source) {
+            TeArchetype::Location to = target->allocateRow(entity);
+            size_t i = 0;
+            try {
+                for (; i < components.size(); i++) {
+                    const TeComponentInfo* component = components[i];
+                    if (component->storage == TeStoragePolicy::SparseSet || source->getColumn(component->id) != -1) continue;
+                    bool first = true;
+                    for (size_t j = 0; j < i && first; j++) {
+                        first = !added[j] || components[j]->id != component->id;
+                    }
+                    if (first) {
+                        component->moveConstruct(target->getComponent(to, target->getColumn(component->id)), values[i]);
+                        added[i] = true;
+                    }
+                }
+            }
+            catch (...) {
+                for (size_t j = 0; j < i; j++) {
+                    if (added[j]) components[j]->destroy(target->getComponent(to, target->getColumn(components[j]->id)));
+                }
+                target->removeRow(to);
+                throw;
+            }
+            moveEntityNOLOCK(entity, target, to);
+        }
+
+        for (size_t i = 0; i < components.size(); i++) {
+            if (added[i]) {
+                target->markChanged(record->location, target->getColumn(components[i]->id), getChangeVersion());
+                continue;
+            }
+            setComponentNOLOCK(entity, *record, components[i], values[i]);
+        }
+        return true;
+    }
+
+    // get entity name
+    const std::string& TeScene::getEntityName(TeScene::Entity entity) {
+        std::shared_lock<std::shared_mutex> lock = lockForRead();
+        return manager.getNameTable().getString(getRecordNOLOCK(entity) ? entityNames[entity.index] : TeNameTable::NONE);
+	}
+
+    TeScene::Entity TeScene::getEntityByName(std::string_view name) {
+        // A name that was never interned can't belong to an entity
+        TeName nameId = manager.getNameTable().find(name);
+        return nameId != TeNameTable::NONE ? getEntityByName(nameId) : Entity{};
+	}
+
+    TeScene::Entity TeScene::getEntityByName(TeName name) {
+        std::shared_lock<std::shared_mutex> lock = lockForRead();
+		return name != TeNameTable::NONE && name < namesToEntities.size() ? namesToEntities[name] : Entity{};
+	}
+
+    TeSceneMemoryStats TeScene::getMemoryStats() {
+        std::shared_lock<std::shared_mutex> lock = lockForRead();
+        TeSceneMemoryStats stats{};
+        stats.chunkBytesReserved = chunkAllocator.getBytesReserved();
+        stats.chunkBytesInUse = chunkAllocator.getBytesInUse();
+
+        std::vector<TeComponentMemoryStats> components(componentTypes.size());
+        for (auto& [signature, archetype] : archetypes) {
+            for (size_t column = 0; column < archetype->getComponents().size(); column++) {
+                TeComponentMemoryStats& component = components[archetype->getComponents()[column]->id];
+                component.bytesUsed += archetype->getColumnBytesUsed(column);
+                component.bytesReserved += archetype->getColumnBytesReserved(column);
+            }
+        }
+        for (auto& componentType : componentTypes) {
+            if (!componentType) continue;
+            TeComponentMemoryStats& component = components[componentType->info.id];
+            component.id = componentType->info.id;
+            component.typeName = componentType->info.type.name();
+            if (componentType->pool) {
+                component.bytesUsed += componentType->pool->size() * componentType->info.size;
+                component.bytesReserved += componentType->pool->capacity() * componentType->info.size;
+            }
+            stats.components.push_back(component);
+        }
+        return stats;
+    }
+
+    TeName TeScene::internName(std::string_view name) {
+        return manager.getNameTable().intern(name);
+    }
+
+    size_t TeECS::getIdByType(TeComponentTypeId type) {
+        ecsMutex_.lock();
+        size_t output = typeToComponentId(type);
+        ecsMutex_.unlock();
+        return output;
+    }
+
+    std::pair<void*, size_t> TeECS::deserializeComponentNOLOCK(std::vector<char> data) {
+		TeArchiveReader reader{ data.data(), data.size() };
+		size_t id = reader.read<size_t>();
+		if (id >= registeredComponents_.size()) {
+			throw std::runtime_error("component isn't registered");
+		}
+		const RegisteredComponent& registered = registeredComponents_[id];
+		if (!registered.archive.read) {
+			throw std::runtime_error("component can't be deserialized");
+		}
+		const TeComponentInfo& info = registered.componentInfo;
+		void* component = ::operator new(info.size, std::align_val_t{ info.alignment });
+		try {
+			registered.archive.read(component, reader);
+		}
+		catch (...) {
+			::operator delete(component, std::align_val_t{ info.alignment });
+			throw;
+		}
+		return std::make_pair(component, id);
+    }
+
+    std::vector<char> TeECS::serializeComponentNOLOCK(void* component, size_t id) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		if (registeredComponents_[id].archive.write) {
+			registeredComponents_[id].archive.write(component, writer);
+		}
+		return output;
+    }
+
+    std::pair<void*, size_t> TeECS::deserializeComponent(std::vector<char> data) {
+		// Malformed data throws, which mustn't leave the lock held
+		std::lock_guard<std::mutex> lock{ ecsMutex_ };
+		return deserializeComponentNOLOCK(std::move(data));
+	}
+
+	TeStagedEntity TeECS::stageEntity(TeArchiveReader& reader) {
+		TeStagedEntity staged;
+		staged.name = reader.readString();
+		uint64_t count = reader.read<uint64_t>();
+		if (count > reader.getRemaining()) {
+			throw std::runtime_error("archive is truncated");
+		}
+
+		std::vector<std::pair<size_t, TeArchiveReader>> components;
+		components.reserve(static_cast<size_t>(count));
+		for (uint64_t i = 0; i < count; i++) {
+			size_t componentId = static_cast<size_t>(reader.read<uint64_t>());
+			components.emplace_back(componentId, reader.readArchive(static_cast<size_t>(reader.read<uint64_t>())));
+		}
+
+		std::vector<RegisteredComponent> registered;
+		registered.reserve(components.size());
+		ecsMutex_.lock();
+		for (auto& [componentId, data] : components) {
+			if (componentId >= registeredComponents_.size()) break;
+			registered.push_back(registeredComponents_[componentId]);
+		}
+		ecsMutex_.unlock();
+		if (registered.size() != components.size()) {
+			throw std::runtime_error("entity has a component that isn't registered");
+		}
+		staged.components.reserve(components.size());
+		for (size_t i = 0; i < components.size(); i++) {
+			if (!registered[i].archive.read) {
+				throw std::runtime_error("entity has a component that can't be deserialized");
+			}
+			staged.components.push_back(std::make_unique<TeComponentArray>(registered[i].componentInfo, 1));
+			staged.components.back()->read(registered[i].archive.read, components[i].second);
+		}
+		return staged;
+	}
+
+    std::vector<char> TeECS::serializeComponent(void* component, size_t id) {
+        ecsMutex_.lock();
+        std::vector<char> output = serializeComponentNOLOCK(component, id);
+        ecsMutex_.unlock();
+        return output;
+    }
+
+    std::string TeECS::getComponentLoggerText(void* component, size_t id) {
+        ecsMutex_.lock();
+		auto& logger = registeredComponents_[id].loggerTextFunc;
+		std::string output = logger ? logger(component) : registeredComponents_[id].type.name();
+        ecsMutex_.unlock();
+        return output;
+    }
+
+    TeECS::~TeECS() {
+        for (TeScene* scene : scenes_) {
+            delete scene;
+        }
+    }
+
+    void TeECS::destroyScene(size_t id) {
+        ecsMutex_.lock();
+        TeScene* scene = scenes_[id];
+        scenes_[id] = nullptr;
+        ecsMutex_.unlock();
+        delete scene;
+    }
+
+    size_t TeECS::createScene() {
+        ecsMutex_.lock();
+		scenes_.push_back(new TeScene(*this));
+		size_t output = scenes_.size() - 1;
+		ecsMutex_.unlock();
+		return output;
+    }
+
+    // Layout: name, component count, then for each component its registration id, byte count and bytes
+    void TeScene::serializeEntity(TeScene::Entity entity, TeArchiveWriter& writer) {
+		manager.getMutex().lock();
+		std::shared_lock<std::shared_mutex> lock = lockForRead();
+
+		EntityRecord* record = getRecordNOLOCK(entity);
+		writer.writeString(manager.getNameTable().getString(record ? entityNames[entity.index] : TeNameTable::NONE));
+		size_t countOffset = writer.reserve<uint64_t>();
+		uint64_t count = 0;
+		auto write = [&](TeComponentTypeId type, const void* component) {
+			size_t componentId = manager.typeToComponentId(type);
+			if (componentId == TeECS::NOT_REGISTERED || !manager.getRegisteredComponents()[componentId].archive.write) {
+				return;
+			}
+			writer.write<uint64_t>(componentId);
+			size_t sizeOffset = writer.reserve<uint64_t>();
+			size_t start = writer.size();
+			manager.getRegisteredComponents()[componentId].archive.write(component, writer);
+			writer.patch<uint64_t>(sizeOffset, writer.size() - start);
+			count++;
+		};
+		if (record) {
+			for (size_t column = 0; column < record->archetype->getComponents().size(); column++) {
+				write(record->archetype->getComponents()[column]->id, record->archetype->getComponent(record->location, column));
+			}
+			for (auto& componentType : componentTypes) {
+				if (componentType && componentType->pool && componentType->pool->contains(entity)) {
+					write(componentType->info.id, componentType->pool->get(entity));
+				}
+			}
+		}
+		writer.patch(countOffset, count);
+
+		manager.getMutex().unlock();
+	}
+
+    std::vector<char> TeScene::serializeEntity(TeScene::Entity entity) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		serializeEntity(entity, writer);
+		return output;
+	}
+
+    TeScene::Entity TeScene::deserializeEntity(TeArchiveReader& reader) {
+		// Components are read before the scene is locked, so malformed data throws without touching it
+		TeStagedEntity staged = manager.stageEntity(reader);
+		TeName name = manager.getNameTable().intern(staged.name);
+
+		// Created with every component under one lock, so nobody sees it half built, and moved
+		// between archetypes once
+		std::vector<const TeComponentInfo*> infos;
+		std::vector<void*> values;
+		infos.reserve(staged.components.size());
+		values.reserve(staged.components.size());
+		lockForWrite();
+		std::unique_lock<std::shared_mutex> lock{ sceneMutex, std::adopt_lock };
+		for (auto& component : staged.components) {
+			infos.push_back(getComponentInfoNOLOCK(component->getInfo()));
+			values.push_back(component->get(0));
+		}
+		Entity entity = createEntityNOLOCK(name);
+		emplaceComponentsNOLOCK(entity, infos, values.data());
+		return entity;
+	}
+
+    TeScene::Entity TeScene::deserializeEntity(const std::vector<char>& data) {
+		TeArchiveReader reader{ data.data(), data.size() };
+		return deserializeEntity(reader);
+	}
+
+    TeScene::Entity TeScene::loadEntityFromFile(std::string path) {
+        std::vector<char> data = TeFile::read(path);
+		if (TeCompression::isCompressed(data)) {
+			data = TeCompression::decompress(data);
+		}
+		return deserializeEntity(data);
+	}
+
+    void TeScene::saveEntityToFile(TeScene::Entity entity, std::string path, bool compressed) {
+        std::vector<char> data = serializeEntity(entity);
+		if (compressed) {
+			data = TeCompression::compress(data);
+		}
+        TeFile::write(path, data);
+    }
+}
\ No newline at end of file
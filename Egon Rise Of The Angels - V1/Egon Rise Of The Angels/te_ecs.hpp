@@ -0,0 +1,879 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include "te_archetype.hpp"
+#include "te_archive.hpp"
+#include "te_component_pool.hpp"
+#include "te_name_table.hpp"
+
+namespace te {
+	class TeECS;
+
+	template<typename... Ts>
+	class TeView;
+
+	class TeReadPhase;
+
+	class TeEntityCommandBuffer;
+
+	class TePrefab;
+
+	class TeMappedFile;
+	class TeSceneCapture;
+
+	class TeWorkerPool;
+
+	class TeSystemScheduler;
+
+	// Component types the calling thread may take non-const access to while this is alive, null
+	// for none. TeSystemScheduler opens one around every system from what the system declared
+	// with writes<>(), and TeWorkerPool::parallelFor passes the caller's on to its helpers
+	class TeWriteAccess {
+	public:
+		TeWriteAccess(const std::vector<TeComponentTypeId>* types) : previous{ current } { current = types; }
+		~TeWriteAccess() { current = previous; }
+
+		TeWriteAccess(const TeWriteAccess&) = delete;
+		TeWriteAccess& operator=(const TeWriteAccess&) = delete;
+
+		// Null outside a system
+		static const std::vector<TeComponentTypeId>* getCurrent() { return current; }
+	private:
+		const std::vector<TeComponentTypeId>* previous;
+		static thread_local const std::vector<TeComponentTypeId>* current;
+	};
+
+	// Memory held for one component type in a scene, across every archetype and its sparse set pool
+	struct TeComponentMemoryStats {
+		TeComponentTypeId id = 0;
+		const char* typeName = "";
+		size_t bytesUsed = 0;
+		size_t bytesReserved = 0;
+
+		// Share of the reserved bytes not holding a live component
+		double getFragmentation() const { return bytesReserved ? 1.0 - static_cast<double>(bytesUsed) / bytesReserved : 0.0; }
+	};
+
+	// An entity read by TeECS::stageEntity, its components constructed but not in any scene yet
+	struct TeStagedEntity {
+		std::string name;
+		std::vector<std::unique_ptr<TeComponentArray>> components;
+	};
+
+	struct TeSceneMemoryStats {
+		std::vector<TeComponentMemoryStats> components;
+		size_t chunkBytesReserved = 0;
+		size_t chunkBytesInUse = 0;
+	};
+
+	// Reads and structural changes follow a phase model: the frame loop opens a TeReadPhase for
+	// update and render, during which reads from that thread take no locks and structural changes
+	// (creating/destroying entities, adding/removing components) wait for the sync point between
+	// phases. Outside a phase every accessor falls back to a shared/exclusive lock
+	class TeScene {
+	public:
+		using Entity = TeEntity;
+
+		TeScene(TeECS& manager);
+
+		~TeScene();
+
+		// Unnamed entities cost no string work at all
+		Entity createEntity(std::string_view name = {});
+
+		Entity duplicateEntity(Entity entity, std::string_view newName);
+
+		// Creates count unnamed entities under a single lock. With a prototype every new entity gets
+		// copies of its components, otherwise they start empty. Throws if a component can't be copied
+		std::vector<Entity> createEntities(size_t count, Entity prototype = {});
+
+		// Creates count unnamed entities from the prefab under a single lock, see TePrefab
+		std::vector<Entity> instantiate(const TePrefab& prefab, size_t count);
+
+		// Snapshots the entity's components into a new prefab, null if the handle is stale.
+		// Throws if a component can't be copied
+		std::unique_ptr<TePrefab> createPrefab(Entity entity);
+
+		void destroyEntity(TeScene::Entity& entity);
+
+		// Destroys every live entity in the range under a single lock, stale handles are skipped
+		void destroyEntities(const Entity* entities, size_t count);
+
+		void destroyEntities(const std::vector<Entity>& entities) { destroyEntities(entities.data(), entities.size()); }
+
+		// Prints a line whenever entities are created, on by default
+		void setLogging(bool enabled) { logging = enabled; }
+
+		// Empty for unnamed entities and stale handles
+		const std::string& getEntityName(TeScene::Entity entity);
+
+		TeScene::Entity getEntityByName(std::string_view name);
+
+		// Lookup by a name from internName, which can be cached to skip hashing the string every call
+		TeScene::Entity getEntityByName(TeName name);
+
+		TeName internName(std::string_view name);
+
+		// Appends the entity's name and registered components to the writer's arena
+		void serializeEntity(TeScene::Entity entity, TeArchiveWriter& writer);
+
+		std::vector<char> serializeEntity(TeScene::Entity entity);
+
+		// Reads one entity written by serializeEntity, leaving the reader after it. Throws if the data
+		// is malformed, in which case the scene is left untouched
+		TeScene::Entity deserializeEntity(TeArchiveReader& reader);
+
+		TeScene::Entity deserializeEntity(const std::vector<char>& data);
+
+		// Reads files written with or without compression
+		TeScene::Entity loadEntityFromFile(std::string path);
+
+		TeECS& iWouldLikeToSpeakToYourManager() { return manager; }
+
+		// Compressed files are smaller and slower to write, see TeCompression
+		void saveEntityToFile(TeScene::Entity entity, std::string path, bool compressed = false);
+
+		// Writes every live entity with its name and registered components into one buffer, see
+		// te_snapshot.hpp. Components of a type are stored together, so saving and loading are a few
+		// large copies instead of a pass per entity. With workers, component types and chunks are
+		// written in parallel, and the ECS lock is only held while registrations are looked up.
+		// The scene is locked exclusively while it's written, so this throws inside a read phase and
+		// waits for a running TeSystemScheduler, use capture() to save without stopping the frame
+		void saveSnapshot(TeArchiveWriter& writer, TeWorkerPool* workers = nullptr);
+
+		std::vector<char> saveSnapshot(TeWorkerPool* workers = nullptr);
+
+		// Adds the snapshot's entities to the scene under a single lock, each one going straight into
+		// its final archetype. Returns them in the order they were saved. Throws if the snapshot is
+		// malformed or was saved with different component registrations
+		std::vector<Entity> loadSnapshot(const char* data, size_t size);
+
+		std::vector<Entity> loadSnapshot(const std::vector<char>& data) { return loadSnapshot(data.data(), data.size()); }
+
+		void saveSnapshotToFile(const std::string& path, TeWorkerPool* workers = nullptr, bool compressed = false);
+
+		// Maps the file instead of reading it. Sparse set pools of trivially copyable components that
+		// are empty when the snapshot loads keep using the mapped pages as their storage, so their
+		// components are only copied, page by page, when they're written to. Compressed snapshots are
+		// decompressed from the mapping instead, in parallel with workers
+		std::vector<Entity> loadSnapshotFromFile(const std::string& path, TeWorkerPool* workers = nullptr);
+
+		// Saves a snapshot and returns only what changed since base, see TeSnapshotDelta. base is
+		// replaced by the new snapshot, so repeated calls produce a chain of deltas. An empty base
+		// means there's no previous snapshot, the first call returns the full snapshot instead,
+		// TeSnapshotDelta::isDelta tells the two apart
+		std::vector<char> saveSnapshotDelta(std::vector<char>& base, TeWorkerPool* workers = nullptr);
+
+		// Replaces every entity in the scene with the snapshot's under a single lock, to roll back
+		// to it. Handles from before go stale, the restored entities are returned in saved order.
+		// Throws if the snapshot is malformed, in which case the scene is left untouched
+		std::vector<Entity> restoreSnapshot(const char* data, size_t size);
+
+		std::vector<Entity> restoreSnapshot(const std::vector<char>& data) { return restoreSnapshot(data.data(), data.size()); }
+
+		// Replays one result of saveSnapshotDelta onto base, which starts empty: a full snapshot
+		// replaces base, a delta turns base into the snapshot it was made from. The scene is then
+		// restored to the new base, so feeding the chain back in order steps it through the saves
+		std::vector<Entity> restoreSnapshotDelta(std::vector<char>& base, const std::vector<char>& next);
+
+		// Captures the scene as it is now without copying it, for saving on another thread while the
+		// scene keeps being used, see TeSceneCapture. Chunks and pools are copied when first written
+		// to, structural changes copy only the chunks and pools they touch. Only the latest capture
+		// of a scene is kept up, taking another one copies the rest of the previous one
+		std::shared_ptr<TeSceneCapture> capture();
+
+		// Component pointers stay valid until the entity's set of components changes.
+		// Asking for a non-const T counts as a write for change tracking, use const T to only read.
+		// Change stamps aren't synchronized, so non-const access needs the calling thread to own T:
+		// inside a scheduled system T has to be in the system's writes<>(), outside one no systems
+		// may be running on the scene. Throws if that's broken. The same goes for non-const Ts in
+		// getComponentInstances and view
+		template<typename T>
+		T* getComponent(TeScene::Entity entity);
+
+		// Copies the component while the scene is locked, for threads outside the frame loop that a
+		// sync point could otherwise move or free it under. Empty if the entity doesn't have T
+		template<typename T>
+		std::optional<T> getComponentCopy(TeScene::Entity entity);
+
+		template<typename T>
+		void addComponent(TeScene::Entity entity, T&& component);
+
+		template<typename T>
+		void removeComponent(TeScene::Entity entity);
+
+		template<typename T>
+		std::unordered_map<TeScene::Entity, T*> getComponentInstances();
+
+		// Iterates every entity that has all of Ts in place, non-const Ts are stamped as changed. Outside a read phase the scene stays
+		// read locked for the lifetime of the view, so don't make structural changes while holding one
+		template<typename... Ts>
+		TeView<Ts...> view();
+
+		bool isAlive(TeScene::Entity entity);
+
+		std::vector<Entity> getEntities();
+
+		TeSceneMemoryStats getMemoryStats();
+
+		// True if the calling thread has this scene open in a read phase
+		bool inReadPhase() const { return readPhaseScene == this; }
+
+		// Added components and writes through non-const accessors are stamped with the current change version
+		uint32_t getChangeVersion() const { return changeVersion.load(); }
+
+		// Starts a new change version and returns it. Passing it to changed<T>() later
+		// yields only the components stamped after this call
+		uint32_t advanceChangeVersion() { return ++changeVersion; }
+
+		// Entities whose T was added or written at or after sinceVersion
+		template<typename T>
+		std::vector<Entity> changed(uint32_t sinceVersion);
+
+		// Number of entities that have T, without visiting them
+		template<typename T>
+		size_t countComponents();
+	private:
+		template<typename... Ts>
+		friend class TeView;
+		friend class TeReadPhase;
+		friend class TeEntityCommandBuffer;
+		friend class TeSceneCapture;
+		friend class TeSystemScheduler;
+
+		// See getComponent, a no-op for const T
+		template<typename T>
+		void checkWriteAccess() const;
+
+		// Pools may borrow the blobs of the snapshot if it comes from a mapping. With replace, every
+		// entity already in the scene is destroyed first under the same lock
+		std::vector<Entity> loadSnapshot(const char* data, size_t size, const std::shared_ptr<TeMappedFile>& mapping, bool replace = false);
+
+		// Shared lock for a read, or an empty lock if the calling thread is inside a read phase
+		std::shared_lock<std::shared_mutex> lockForRead();
+
+		// Takes the exclusive lock for a structural change. Throws if the calling thread is inside
+		// a read phase of this scene, since the change could never get the lock. The active capture,
+		// if any, gets its copy of the entity table first
+		void lockForWrite();
+
+		static thread_local const TeScene* readPhaseScene;
+
+		// Call before writing to components in a chunk or pool, position being the component's
+		// index in a pool or SIZE_MAX for every component of the chunk or pool
+		void prepareWriteNOLOCK(const void* storage, size_t position = SIZE_MAX) {
+			if (capturing.load()) preserveForCaptureNOLOCK(storage, position);
+		}
+
+		void preserveForCaptureNOLOCK(const void* storage, size_t position);
+
+		// Call before emplacing or removing the entity's component in the pool, or growing the pool to
+		// hold capacity components. Only growing moves every component of a pool
+		void preparePoolEmplaceNOLOCK(TeComponentPool* pool, Entity entity);
+
+		void preparePoolRemoveNOLOCK(TeComponentPool* pool, Entity entity);
+
+		void preparePoolReserveNOLOCK(TeComponentPool* pool, size_t capacity) {
+			if (capacity > pool->capacity()) prepareWriteNOLOCK(pool);
+		}
+
+		void preserveEntitiesForCaptureNOLOCK();
+
+		// Call before removing the row, which also moves the archetype's last row
+		void prepareRemoveRowNOLOCK(TeArchetype* archetype, TeArchetype::Location location) {
+			if (capturing.load()) {
+				preserveForCaptureNOLOCK(archetype->getChunks()[location.chunk], SIZE_MAX);
+				preserveForCaptureNOLOCK(archetype->getChunks().back(), SIZE_MAX);
+			}
+		}
+
+		// Copies what the active capture still needs and stops tracking writes for it
+		void detachCaptureNOLOCK();
+
+		// Indexed by Entity::index, archetype is null while the slot is free
+		struct EntityRecord {
+			TeArchetype* archetype = nullptr;
+			TeArchetype::Location location{};
+			uint32_t generation = 0;
+		};
+
+		EntityRecord* getRecordNOLOCK(Entity entity);
+
+		// Null if the entity doesn't have T, doesn't count as a write
+		template<typename T>
+		const T* findComponentNOLOCK(Entity entity) {
+			EntityRecord* record = getRecordNOLOCK(entity);
+			if (!record) {
+				return nullptr;
+			}
+			int column = record->archetype->getColumn(getComponentTypeId<T>());
+			if (column != -1) {
+				return static_cast<const T*>(record->archetype->getComponent(record->location, column));
+			}
+			TeComponentPool* pool = getPoolNOLOCK(getComponentTypeId<T>());
+			return pool ? static_cast<const T*>(pool->get(entity)) : nullptr;
+		}
+
+		Entity allocateEntityNOLOCK();
+
+		Entity createEntityNOLOCK(TeName name);
+
+		void setEntityNameNOLOCK(Entity entity, TeName name);
+
+		void destroyEntityNOLOCK(Entity entity);
+
+		// Makes room for count more entities in the per-entity arrays
+		void reserveEntitiesNOLOCK(size_t count);
+
+		bool isCopyableNOLOCK(Entity entity);
+
+		// Fills output with count new unnamed entities holding copies of the prototype's components
+		void copyEntityNOLOCK(Entity prototype, Entity* output, size_t count);
+
+		// Fills output with count new unnamed entities holding copies of the given components, which
+		// must use this scene's component infos and stay valid while the entities are created
+		void createCopiesNOLOCK(const std::vector<std::pair<const TeComponentInfo*, const void*>>& components, Entity* output, size_t count);
+
+		const TeComponentInfo* getComponentInfoNOLOCK(const TeComponentInfo& info);
+
+		template<typename T>
+		const TeComponentInfo* getComponentInfoNOLOCK() {
+			TeComponentTypeId id = getComponentTypeId<T>();
+			if (id < componentTypes.size() && componentTypes[id]) {
+				return &componentTypes[id]->info;
+			}
+			return getComponentInfoNOLOCK(TeComponentInfo::of<T>());
+		}
+
+		TeArchetype* getArchetypeNOLOCK(std::vector<const TeComponentInfo*> components);
+
+		TeArchetype* getArchetypeWithNOLOCK(TeArchetype* archetype, const TeComponentInfo* component);
+
+		TeArchetype* getArchetypeWithoutNOLOCK(TeArchetype* archetype, TeComponentTypeId id);
+
+		void moveEntityNOLOCK(Entity entity, TeArchetype* target) { moveEntityNOLOCK(entity, target, target->allocateRow(entity)); }
+
+		// Moves the entity into a row already allocated in target
+		void moveEntityNOLOCK(Entity entity, TeArchetype* target, TeArchetype::Location to);
+
+		// Null unless the component type uses sparse set storage in this scene
+		TeComponentPool* getPoolNOLOCK(TeComponentTypeId id) {
+			return id < componentTypes.size() && componentTypes[id] ? componentTypes[id]->pool.get() : nullptr;
+		}
+
+		void removeComponentNOLOCK(Entity entity, TeComponentTypeId id);
+
+		// Moves value into the entity's component, assigning over any previous instance. The entity
+		// only gains a component once it's constructed, so a throwing move leaves the scene as it
+		// was. Returns false if the entity handle is stale
+		bool emplaceComponentNOLOCK(Entity entity, const TeComponentInfo* component, void* value);
+
+		// Moves values[i] into the entity's i-th component with at most one archetype move. If a
+		// move throws, components after it aren't added. Returns false if the entity handle is stale
+		bool emplaceComponentsNOLOCK(Entity entity, const std::vector<const TeComponentInfo*>& components, void* const* values);
+
+		// Moves value into the component, which the entity must either have or keep in a pool
+		void setComponentNOLOCK(Entity entity, EntityRecord& record, const TeComponentInfo* component, void* value);
+
+		std::shared_mutex sceneMutex;
+
+		std::atomic<uint32_t> changeVersion{ 0 };
+
+		std::atomic<bool> logging{ true };
+
+		// Set while a TeSystemScheduler runs systems on the scene
+		std::atomic<bool> systemsRunning{ false };
+
+		std::vector<EntityRecord> entityRecords;
+		std::vector<uint32_t> freeEntityIndices;
+
+		// Indexed by Entity::index and by TeName respectively
+		std::vector<TeName> entityNames;
+		std::vector<Entity> namesToEntities;
+
+		struct ComponentType {
+			TeComponentInfo info;
+			std::unique_ptr<TeComponentPool> pool;
+		};
+
+		// Backs every archetype chunk in the scene, declared first so it's released last
+		TeChunkAllocator chunkAllocator;
+
+		// Indexed by TeComponentTypeId, null for types this scene hasn't seen yet
+		std::vector<std::unique_ptr<ComponentType>> componentTypes;
+
+		std::map<std::vector<TeComponentTypeId>, std::unique_ptr<TeArchetype>> archetypes;
+		TeArchetype* emptyArchetype;
+
+		TeECS& manager;
+
+		// Set while the active capture still has blocks left to preserve
+		std::shared_ptr<TeSceneCapture> activeCapture;
+		std::atomic<bool> capturing{ false };
+	};
+
+	// Holds the scene open for reading until destroyed. One shared lock per phase replaces
+	// a lock per accessor call, structural changes from other threads run once the phase ends
+	class TeReadPhase {
+	public:
+		TeReadPhase(TeScene& scene) : TeReadPhase(scene, true) {}
+		~TeReadPhase();
+
+		TeReadPhase(const TeReadPhase&) = delete;
+		TeReadPhase& operator=(const TeReadPhase&) = delete;
+
+		// Marks the calling thread as part of a phase another thread holds, without taking the lock.
+		// Only for work that is guaranteed to finish before that phase ends, like scheduled systems
+		static TeReadPhase join(TeReadPhase& phase) { return TeReadPhase(phase.scene, false); }
+	private:
+		TeReadPhase(TeScene& scene, bool lockScene);
+
+		TeScene& scene;
+		const TeScene* previousScene;
+		std::shared_lock<std::shared_mutex> lock;
+	};
+
+	template<typename... Ts>
+	class TeView {
+	public:
+		using Entity = TeScene::Entity;
+
+		class Iterator {
+		public:
+			Iterator(TeView* view, bool end) : view{ view } {
+				archetype = end ? view->archetypes().end() : view->archetypes().begin();
+				seekArchetype();
+				skipUnmatched();
+			}
+
+			std::tuple<Entity, Ts&...> operator*() const {
+				return dereference(std::index_sequence_for<Ts...>{});
+			}
+
+			Iterator& operator++() {
+				advance();
+				skipUnmatched();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const {
+				return archetype == other.archetype && chunkIndex == other.chunkIndex && row == other.row;
+			}
+			bool operator!=(const Iterator& other) const { return !(*this == other); }
+		private:
+			template<size_t... Is>
+			std::tuple<Entity, Ts&...> dereference(std::index_sequence<Is...>) const {
+				Entity entity = chunk->entities[row];
+				return { entity, *view->template fetch<Is>(chunk, columns, row, entity)... };
+			}
+
+			void advance() {
+				if (++row == chunk->count) {
+					row = 0;
+					chunkIndex++;
+					seekArchetype();
+				}
+			}
+
+			// Rows only match once every sparse set component of the view is present too
+			void skipUnmatched() {
+				while (archetype != view->archetypes().end() && !view->hasSparse(chunk->entities[row])) {
+					advance();
+				}
+			}
+
+			// Moves to the next non-empty chunk of an archetype that has every component of the view
+			void seekArchetype() {
+				auto end = view->archetypes().end();
+				for (; archetype != end; ++archetype, chunkIndex = 0) {
+					auto& chunks = archetype->second->getChunks();
+					if (chunkIndex >= chunks.size() || (chunkIndex == 0 && !view->match(*archetype->second, columns))) {
+						continue;
+					}
+					chunk = chunks[chunkIndex];
+					return;
+				}
+				chunkIndex = 0;
+				row = 0;
+			}
+
+			TeView* view;
+			std::map<std::vector<TeComponentTypeId>, std::unique_ptr<TeArchetype>>::iterator archetype;
+			std::array<int, sizeof...(Ts)> columns{};
+			TeChunk* chunk = nullptr;
+			size_t chunkIndex = 0;
+			uint32_t row = 0;
+		};
+
+		TeView(TeScene& scene) : scene{ scene }, lock{ (scene.checkWriteAccess<Ts>(), ..., scene.lockForRead()) }, pools{ scene.getPoolNOLOCK(getComponentTypeId<Ts>())... }, version{ scene.getChangeVersion() } {}
+
+		Iterator begin() { return Iterator(this, false); }
+		Iterator end() { return Iterator(this, true); }
+
+		// Calls func(entity, components...) for every match, walking each chunk's arrays directly.
+		// A view made only of sparse set components walks the smallest pool instead
+		template<typename F>
+		void each(F&& func) { eachChanged(0, func); }
+
+		// Like each, but only for matches whose first component was added or written at or after
+		// sinceVersion, see TeScene::changed. Chunks nobody wrote it in since are skipped whole
+		template<typename F>
+		void eachChanged(uint32_t sinceVersion, F&& func) {
+			std::array<int, sizeof...(Ts)> columns{};
+			if (std::all_of(pools.begin(), pools.end(), [](TeComponentPool* pool) { return pool != nullptr; })) {
+				eachInPool(func, sinceVersion, std::index_sequence_for<Ts...>{});
+				return;
+			}
+			for (auto& [signature, archetype] : archetypes()) {
+				if (!match(*archetype, columns)) continue;
+				for (TeChunk* chunk : archetype->getChunks()) {
+					if (!pools[0] && chunk->columnVersions[columns[0]] < sinceVersion) continue;
+					eachInChunk(func, chunk, columns, sinceVersion, std::index_sequence_for<Ts...>{});
+				}
+			}
+		}
+	private:
+		auto& archetypes() { return scene.archetypes; }
+
+		// Only components kept in archetypes take part in matching, sparse ones are checked per row
+		bool match(const TeArchetype& archetype, std::array<int, sizeof...(Ts)>& columns) const {
+			size_t i = 0;
+			for (TeComponentTypeId id : { getComponentTypeId<Ts>()... }) {
+				columns[i] = pools[i] ? -1 : archetype.getColumn(id);
+				if (!pools[i] && columns[i] == -1) return false;
+				i++;
+			}
+			return true;
+		}
+
+		bool hasSparse(Entity entity) const {
+			for (TeComponentPool* pool : pools) {
+				if (pool && !pool->contains(entity)) return false;
+			}
+			return true;
+		}
+
+		template<size_t I>
+		auto* fetch(TeChunk* chunk, const std::array<int, sizeof...(Ts)>& columns, uint32_t row, Entity entity) const {
+			using T = std::tuple_element_t<I, std::tuple<Ts...>>;
+			if (pools[I]) {
+				T* component = static_cast<T*>(pools[I]->get(entity));
+				if constexpr (!std::is_const_v<T>) {
+					if (component) {
+						scene.prepareWriteNOLOCK(pools[I], component - reinterpret_cast<T*>(pools[I]->getData()));
+						pools[I]->markChanged(entity, version);
+					}
+				}
+				return component;
+			}
+			if constexpr (!std::is_const_v<T>) {
+				scene.prepareWriteNOLOCK(chunk);
+				chunk->markChanged(columns[I], row, version);
+			}
+			return reinterpret_cast<T*>(chunk->columns[columns[I]]) + row;
+		}
+
+		bool changedSince(TeChunk* chunk, const std::array<int, sizeof...(Ts)>& columns, uint32_t row, Entity entity, uint32_t sinceVersion) const {
+			if (!pools[0]) {
+				return chunk->versions[columns[0]][row] >= sinceVersion;
+			}
+			char* component = static_cast<char*>(pools[0]->get(entity));
+			return component && pools[0]->getVersions()[(component - pools[0]->getData()) / pools[0]->getComponentInfo()->size] >= sinceVersion;
+		}
+
+		template<typename F, size_t... Is>
+		void eachInChunk(F& func, TeChunk* chunk, const std::array<int, sizeof...(Ts)>& columns, uint32_t sinceVersion, std::index_sequence<Is...>) {
+			for (uint32_t row = 0; row < chunk->count; row++) {
+				Entity entity = chunk->entities[row];
+				if (sinceVersion && !changedSince(chunk, columns, row, entity, sinceVersion)) continue;
+				std::tuple<Ts*...> components{ fetch<Is>(chunk, columns, row, entity)... };
+				if (((std::get<Is>(components) != nullptr) && ...)) {
+					func(entity, *std::get<Is>(components)...);
+				}
+			}
+		}
+
+		template<typename F, size_t... Is>
+		void eachInPool(F& func, uint32_t sinceVersion, std::index_sequence<Is...>) {
+			TeComponentPool* smallest = *std::min_element(pools.begin(), pools.end(), [](TeComponentPool* a, TeComponentPool* b) { return a->size() < b->size(); });
+			for (size_t i = 0; i < smallest->size(); i++) {
+				Entity entity = smallest->getEntities()[i];
+				if (sinceVersion && !changedSince(nullptr, {}, 0, entity, sinceVersion)) continue;
+				std::tuple<Ts*...> components{ fetch<Is>(nullptr, {}, 0, entity)... };
+				if (((std::get<Is>(components) != nullptr) && ...)) {
+					func(entity, *std::get<Is>(components)...);
+				}
+			}
+		}
+
+		TeScene& scene;
+		std::shared_lock<std::shared_mutex> lock;
+		std::array<TeComponentPool*, sizeof...(Ts)> pools;
+		uint32_t version;
+	};
+
+	template<typename T, typename = void>
+	struct TeHasLoggerText : std::false_type {};
+
+	template<typename T>
+	struct TeHasLoggerText<T, std::void_t<decltype(T::loggerText(std::declval<void*>()))>> : std::true_type {};
+
+	class TeECS {
+	public:
+		struct RegisteredComponent {
+			// Empty unless the component defines them, logger text is generated for components with fields
+			std::function<std::string(void*)> loggerTextFunc;
+			std::function<std::vector<char>(void*)> serializeFunc;
+			std::function<void* (std::vector<char>)> deserializeFunc;
+			// What saving and loading use, null if the component can't be serialized
+			TeArchiveFuncs archive;
+			std::type_index type = typeid(void);
+			TeComponentInfo componentInfo;
+		};
+
+		static constexpr size_t NOT_REGISTERED = SIZE_MAX;
+
+		size_t getIdByType(TeComponentTypeId type);
+		std::vector<RegisteredComponent>& getRegisteredComponents() { return registeredComponents_; }
+		std::mutex& getMutex() { return ecsMutex_; }
+		TeNameTable& getNameTable() { return names_; }
+		size_t typeToComponentId(TeComponentTypeId type) { return type < typeToComponentId_.size() ? typeToComponentId_[type] : NOT_REGISTERED; }
+		bool isRegisteredNOLOCK(TeComponentTypeId type) { return typeToComponentId(type) != NOT_REGISTERED; }
+
+		// data starts with the registration id. The component is allocated on its own, free it with
+		// the registration's componentInfo.deleteInstance
+		std::pair<void*, size_t> deserializeComponentNOLOCK(std::vector<char> data);
+
+		std::vector<char> serializeComponentNOLOCK(void* component, size_t id);
+
+		std::pair<void*, size_t> deserializeComponent(std::vector<char> data);
+
+		std::vector<char> serializeComponent(void* component, size_t id);
+
+		std::string getComponentLoggerText(void* component, size_t id);
+
+		// Reads one entity written by TeScene::serializeEntity without adding it to a scene, leaving
+		// the reader after it. Safe to call from any thread, throws if the data is malformed
+		TeStagedEntity stageEntity(TeArchiveReader& reader);
+
+		~TeECS();
+
+		size_t createScene();
+
+		// Destroys the scene and releases all of its component memory, the id stays reserved
+		void destroyScene(size_t id);
+
+		// Null once the scene is destroyed
+		TeScene* getScene(size_t id) { return scenes_[id]; }
+
+		std::vector<TeScene*>& getScenes() { return scenes_; }
+
+		// Components must be registered before a scene first uses them for the storage policy to apply
+		template<typename T>
+		size_t registerComponent(TeStoragePolicy storage = TeStoragePolicy::Archetype);
+	private:
+		std::vector<TeScene*> scenes_;
+
+		// Registration id for each TeComponentTypeId
+		std::vector<size_t> typeToComponentId_;
+
+		std::vector<RegisteredComponent> registeredComponents_;
+
+		// Shared by every scene, so names can be cached across scenes
+		TeNameTable names_;
+
+		std::mutex ecsMutex_;
+	};
+	
+	// Template function definitions
+	template<typename T>
+	void TeScene::addComponent(Entity entity, T&& component) {
+		using Component = std::remove_cv_t<std::remove_reference_t<T>>;
+		// Built before the scene is locked, so a throwing constructor leaves it untouched
+		Component value(std::forward<T>(component));
+		lockForWrite();
+		std::unique_lock<std::shared_mutex> lock{ sceneMutex, std::adopt_lock };
+		emplaceComponentNOLOCK(entity, getComponentInfoNOLOCK<Component>(), &value);
+	}
+
+	template<typename T>
+	void TeScene::removeComponent(Entity entity) {
+		lockForWrite();
+		std::unique_lock<std::shared_mutex> lock{ sceneMutex, std::adopt_lock };
+		removeComponentNOLOCK(entity, getComponentTypeId<T>());
+	}
+
+	template<typename T>
+	void TeScene::checkWriteAccess() const {
+		if constexpr (!std::is_const_v<T>) {
+			const std::vector<TeComponentTypeId>* writes = TeWriteAccess::getCurrent();
+			bool owned = writes ? std::find(writes->begin(), writes->end(), getComponentTypeId<T>()) != writes->end() : !systemsRunning.load();
+			if (!owned) {
+				throw std::runtime_error(std::string("non-const access to ") + typeid(T).name() + " without owning it, declare it with writes<>() or read it as const");
+			}
+		}
+	}
+
+	template<typename T>
+	std::optional<T> TeScene::getComponentCopy(Entity entity) {
+		std::shared_lock<std::shared_mutex> lock = lockForRead();
+		if (const T* component = findComponentNOLOCK<T>(entity)) {
+			return *component;
+		}
+		return std::nullopt;
+	}
+
+	template<typename T>
+	std::unordered_map<TeScene::Entity, T*> TeScene::getComponentInstances() {
+		checkWriteAccess<T>();
+		std::shared_lock<std::shared_mutex> lock = lockForRead();
+		std::unordered_map<Entity, T*> instances;
+		for (auto& [signature, archetype] : archetypes) {
+			int column = archetype->getColumn(getComponentTypeId<T>());
+			if (column == -1) continue;
+			for (TeChunk* chunk : archetype->getChunks()) {
+				T* components = reinterpret_cast<T*>(chunk->columns[column]);
+				if constexpr (!std::is_const_v<T>) {
+					prepareWriteNOLOCK(chunk);
+				}
+				for (uint32_t row = 0; row < chunk->count; row++) {
+					instances[chunk->entities[row]] = &components[row];
+					if constexpr (!std::is_const_v<T>) {
+						chunk->markChanged(column, row, getChangeVersion());
+					}
+				}
+			}
+		}
+		if (TeComponentPool* pool = getPoolNOLOCK(getComponentTypeId<T>())) {
+			if constexpr (!std::is_const_v<T>) {
+				prepareWriteNOLOCK(pool);
+			}
+			for (size_t i = 0; i < pool->size(); i++) {
+				instances[pool->getEntities()[i]] = reinterpret_cast<T*>(pool->getData()) + i;
+				if constexpr (!std::is_const_v<T>) {
+					pool->markChanged(pool->getEntities()[i], getChangeVersion());
+				}
+			}
+		}
+		return instances;
+	}
+
+	template<typename T>
+	std::vector<TeScene::Entity> TeScene::changed(uint32_t sinceVersion) {
+		std::shared_lock<std::shared_mutex> lock = lockForRead();
+		std::vector<Entity> output;
+		for (auto& [signature, archetype] : archetypes) {
+			int column = archetype->getColumn(getComponentTypeId<T>());
+			if (column == -1) continue;
+			for (TeChunk* chunk : archetype->getChunks()) {
+				if (chunk->columnVersions[column] < sinceVersion) continue;
+				const uint32_t* versions = chunk->versions[column];
+				for (uint32_t row = 0; row < chunk->count; row++) {
+					if (versions[row] >= sinceVersion) {
+						output.push_back(chunk->entities[row]);
+					}
+				}
+			}
+		}
+		if (TeComponentPool* pool = getPoolNOLOCK(getComponentTypeId<T>())) {
+			for (size_t i = 0; i < pool->size(); i++) {
+				if (pool->getVersions()[i] >= sinceVersion) {
+					output.push_back(pool->getEntities()[i]);
+				}
+			}
+		}
+		return output;
+	}
+
+	template<typename T>
+	size_t TeScene::countComponents() {
+		std::shared_lock<std::shared_mutex> lock = lockForRead();
+		if (TeComponentPool* pool = getPoolNOLOCK(getComponentTypeId<T>())) {
+			return pool->size();
+		}
+		size_t count = 0;
+		for (auto& [signature, archetype] : archetypes) {
+			if (archetype->getColumn(getComponentTypeId<T>()) != -1) {
+				count += archetype->getEntityCount();
+			}
+		}
+		return count;
+	}
+
+	template<typename... Ts>
+	TeView<Ts...> TeScene::view() {
+		return TeView<Ts...>(*this);
+	}
+
+	template<typename T>
+	size_t TeECS::registerComponent(TeStoragePolicy storage) {
+		ecsMutex_.lock();
+		size_t nextId = registeredComponents_.size();
+
+		RegisteredComponent& registeredComponent = registeredComponents_.emplace_back();
+		if constexpr (TeHasVectorSerialize<T>::value) {
+			registeredComponent.deserializeFunc = &T::deserialize;
+			registeredComponent.serializeFunc = &T::serialize;
+		}
+		if constexpr (TeHasLoggerText<T>::value) {
+			registeredComponent.loggerTextFunc = &T::loggerText;
+		}
+		else if constexpr (TeHasFields<T>::value) {
+			registeredComponent.loggerTextFunc = &teFieldsText<T>;
+		}
+		registeredComponent.archive = TeArchiveFuncs::of<T>();
+
+		registeredComponent.type = typeid(T);
+		registeredComponent.componentInfo = TeComponentInfo::of<T>();
+		registeredComponent.componentInfo.storage = storage;
+		TeComponentTypeId typeId = getComponentTypeId<T>();
+		if (typeId >= typeToComponentId_.size()) {
+			typeToComponentId_.resize(typeId + 1, NOT_REGISTERED);
+		}
+		typeToComponentId_[typeId] = nextId;
+		ecsMutex_.unlock();
+		return nextId;
+	}
+
+	template<typename T>
+	T* TeScene::getComponent(Entity entity) {
+		checkWriteAccess<T>();
+		std::shared_lock<std::shared_mutex> lock = lockForRead();
+		EntityRecord* record = getRecordNOLOCK(entity);
+		if (record) {
+			int column = record->archetype->getColumn(getComponentTypeId<T>());
+			if (column != -1) {
+				if constexpr (!std::is_const_v<T>) {
+					prepareWriteNOLOCK(record->archetype->getChunks()[record->location.chunk]);
+					record->archetype->markChanged(record->location, column, getChangeVersion());
+				}
+				return static_cast<T*>(record->archetype->getComponent(record->location, column));
+			}
+			if (TeComponentPool* pool = getPoolNOLOCK(getComponentTypeId<T>())) {
+				T* component = static_cast<T*>(pool->get(entity));
+				if constexpr (!std::is_const_v<T>) {
+					if (component) {
+						prepareWriteNOLOCK(pool, component - reinterpret_cast<T*>(pool->getData()));
+						pool->markChanged(entity, getChangeVersion());
+					}
+				}
+				return component;
+			}
+		}
+		return nullptr;
+	}
+}
@@ -0,0 +1,178 @@
+#include "te_entity_command_buffer.hpp"
+
+namespace te {
+	static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+	TeEntityCommandBuffer::~TeEntityCommandBuffer() {
+		clearNOLOCK();
+		for (char* block : blocks) {
+			::operator delete(block, std::align_val_t{ BLOCK_ALIGNMENT });
+		}
+	}
+
+	TeEntityCommandBuffer::Entity TeEntityCommandBuffer::createEntity(std::string_view name) {
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+		Command& command = commands.emplace_back();
+		command.type = CommandType::CreateEntity;
+		command.entity = { pendingEntities++, PENDING_GENERATION };
+		if (!name.empty()) {
+			command.name = names.size();
+			names.emplace_back(name);
+		}
+		return command.entity;
+	}
+
+	void TeEntityCommandBuffer::destroyEntity(Entity entity) {
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+		Command& command = commands.emplace_back();
+		command.type = CommandType::DestroyEntity;
+		command.entity = entity;
+	}
+
+	void TeEntityCommandBuffer::addComponent(Entity entity, const TeComponentInfo& info, void* component) {
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+		const TeComponentInfo* buffered = info.id < componentInfos.size() && componentInfos[info.id] ? componentInfos[info.id].get() : getComponentInfoNOLOCK(info);
+		void* data = allocateNOLOCK(buffered->size, buffered->alignment);
+		buffered->moveConstruct(data, component);
+
+		Command& command = commands.emplace_back();
+		command.type = CommandType::AddComponent;
+		command.entity = entity;
+		command.component = buffered;
+		command.data = data;
+		command.componentType = info.id;
+	}
+
+	bool TeEntityCommandBuffer::isEmpty() {
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+		return commands.empty();
+	}
+
+	std::vector<TeEntityCommandBuffer::Entity> TeEntityCommandBuffer::playback(TeScene& scene) {
+		// Nothing to do isn't worth waiting for the exclusive lock, or making an active capture copy anything
+		if (isEmpty()) {
+			return {};
+		}
+		// Scene first, so a playback from inside a read phase throws before the buffer is locked
+		scene.lockForWrite();
+		std::unique_lock<std::shared_mutex> sceneLock{ scene.sceneMutex, std::adopt_lock };
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+
+		// Pending handles are numbered in creation order, so they index straight into this
+		std::vector<Entity> created;
+		auto resolve = [&created](Entity entity) {
+			if (!isPending(entity)) {
+				return entity;
+			}
+			return entity.index < created.size() ? created[entity.index] : Entity{};
+		};
+
+		std::vector<const TeComponentInfo*> batch;
+		std::vector<void*> values;
+		try {
+			created.reserve(pendingEntities);
+			for (size_t i = 0; i < commands.size(); i++) {
+				Command& command = commands[i];
+				switch (command.type) {
+				case CommandType::CreateEntity:
+					created.push_back(scene.createEntityNOLOCK(command.name == NO_NAME ? TeNameTable::NONE : scene.internName(names[command.name])));
+					break;
+				case CommandType::DestroyEntity:
+					scene.destroyEntityNOLOCK(resolve(command.entity));
+					break;
+				case CommandType::RemoveComponent:
+					scene.removeComponentNOLOCK(resolve(command.entity), command.componentType);
+					break;
+				case CommandType::AddComponent: {
+					size_t end = i + 1;
+					while (end < commands.size() && commands[end].type == CommandType::AddComponent && commands[end].entity == command.entity) {
+						end++;
+					}
+					batch.clear();
+					values.clear();
+					for (size_t j = i; j < end; j++) {
+						batch.push_back(scene.getComponentInfoNOLOCK(*commands[j].component));
+					}
+					// The payloads are taken out of the buffer before the scene sees them, from here on
+					// only this destroys them, whether or not the scene throws
+					for (size_t j = i; j < end; j++) {
+						values.push_back(commands[j].data);
+						commands[j].data = nullptr;
+					}
+					auto destroyValues = [&] {
+						for (size_t j = 0; j < values.size(); j++) {
+							commands[i + j].component->destroy(values[j]);
+						}
+					};
+					try {
+						scene.emplaceComponentsNOLOCK(resolve(command.entity), batch, values.data());
+					}
+					catch (...) {
+						destroyValues();
+						throw;
+					}
+					destroyValues();
+					i = end - 1;
+					break;
+				}
+				}
+			}
+		}
+		catch (...) {
+			clearNOLOCK();
+			throw;
+		}
+
+		clearNOLOCK();
+		return created;
+	}
+
+	void* TeEntityCommandBuffer::allocateNOLOCK(size_t size, size_t alignment) {
+		if (size + alignment > BLOCK_SIZE || alignment > BLOCK_ALIGNMENT) {
+			void* data = ::operator new(size, std::align_val_t{ alignment });
+			largeAllocations.emplace_back(data, alignment);
+			return data;
+		}
+		if (blocks.empty()) {
+			blocks.push_back(static_cast<char*>(::operator new(BLOCK_SIZE, std::align_val_t{ BLOCK_ALIGNMENT })));
+		}
+		size_t offset = (blockOffset + alignment - 1) & ~(alignment - 1);
+		if (offset + size > BLOCK_SIZE) {
+			if (++currentBlock == blocks.size()) {
+				blocks.push_back(static_cast<char*>(::operator new(BLOCK_SIZE, std::align_val_t{ BLOCK_ALIGNMENT })));
+			}
+			offset = 0;
+		}
+		blockOffset = offset + size;
+		return blocks[currentBlock] + offset;
+	}
+
+	const TeComponentInfo* TeEntityCommandBuffer::getComponentInfoNOLOCK(const TeComponentInfo& info) {
+		if (info.id >= componentInfos.size()) {
+			componentInfos.resize(info.id + 1);
+		}
+		if (!componentInfos[info.id]) {
+			componentInfos[info.id] = std::make_unique<TeComponentInfo>(info);
+		}
+		return componentInfos[info.id].get();
+	}
+
+	void TeEntityCommandBuffer::clearNOLOCK() {
+		for (Command& command : commands) {
+			if (command.type == CommandType::AddComponent && command.data) {
+				command.component->destroy(command.data);
+			}
+		}
+		commands.clear();
+		names.clear();
+		pendingEntities = 0;
+
+		// Blocks are kept for the next batch, only oversized payloads go back to the heap
+		currentBlock = 0;
+		blockOffset = 0;
+		for (auto& [data, alignment] : largeAllocations) {
+			::operator delete(data, std::align_val_t{ alignment });
+		}
+		largeAllocations.clear();
+	}
+}
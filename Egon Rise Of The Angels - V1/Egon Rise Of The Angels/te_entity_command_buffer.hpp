@@ -0,0 +1,115 @@
+#pragma once
+
+#include "te_ecs.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace te {
+	// Records structural changes from any thread and applies them to a scene in one batch at a
+	// sync point, under a single exclusive lock. Entities created through the buffer get a pending
+	// handle that can only be used for further commands in the same buffer until playback
+	class TeEntityCommandBuffer {
+	public:
+		using Entity = TeScene::Entity;
+
+		TeEntityCommandBuffer() = default;
+		~TeEntityCommandBuffer();
+
+		TeEntityCommandBuffer(const TeEntityCommandBuffer&) = delete;
+		TeEntityCommandBuffer& operator=(const TeEntityCommandBuffer&) = delete;
+
+		Entity createEntity(std::string_view name = {});
+
+		void destroyEntity(Entity entity);
+
+		template<typename T>
+		void addComponent(Entity entity, T&& component);
+
+		// Moves an already constructed component of the described type into the buffer, the caller
+		// still destroys what's left of it
+		void addComponent(Entity entity, const TeComponentInfo& info, void* component);
+
+		template<typename T>
+		void removeComponent(Entity entity);
+
+		// Applies every recorded command in the order it was recorded, then clears the buffer.
+		// Consecutive components added to the same entity cost one archetype move between them.
+		// Returns the created entities, indexed by the index of their pending handle. If a command
+		// throws, the ones before it stay applied and the buffer is still cleared
+		std::vector<Entity> playback(TeScene& scene);
+
+		bool isEmpty();
+
+		static bool isPending(Entity entity) { return entity.generation == PENDING_GENERATION; }
+	private:
+		static constexpr uint32_t PENDING_GENERATION = UINT32_MAX;
+		static constexpr size_t BLOCK_SIZE = 64 * 1024;
+		static constexpr size_t NO_NAME = SIZE_MAX;
+
+		enum class CommandType {
+			CreateEntity,
+			DestroyEntity,
+			AddComponent,
+			RemoveComponent
+		};
+
+		struct Command {
+			CommandType type;
+			Entity entity;
+			const TeComponentInfo* component = nullptr;
+			void* data = nullptr;
+			TeComponentTypeId componentType = 0;
+			size_t name = NO_NAME;
+		};
+
+		// Component payloads are packed into reusable blocks instead of one heap allocation each
+		void* allocateNOLOCK(size_t size, size_t alignment);
+
+		const TeComponentInfo* getComponentInfoNOLOCK(const TeComponentInfo& info);
+
+		// Destroys any payloads still in the buffer and resets it for reuse
+		void clearNOLOCK();
+
+		std::mutex bufferMutex;
+
+		std::vector<Command> commands;
+		std::vector<std::string> names;
+		uint32_t pendingEntities = 0;
+
+		// Indexed by TeComponentTypeId
+		std::vector<std::unique_ptr<TeComponentInfo>> componentInfos;
+
+		std::vector<char*> blocks;
+		size_t currentBlock = 0;
+		size_t blockOffset = 0;
+		std::vector<std::pair<void*, size_t>> largeAllocations;
+	};
+
+	template<typename T>
+	void TeEntityCommandBuffer::addComponent(Entity entity, T&& component) {
+		using Component = std::remove_cv_t<std::remove_reference_t<T>>;
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+		TeComponentTypeId id = getComponentTypeId<Component>();
+		const TeComponentInfo* info = id < componentInfos.size() && componentInfos[id] ? componentInfos[id].get() : getComponentInfoNOLOCK(TeComponentInfo::of<Component>());
+		void* data = allocateNOLOCK(sizeof(Component), alignof(Component));
+		new (data) Component(std::forward<T>(component));
+
+		Command& command = commands.emplace_back();
+		command.type = CommandType::AddComponent;
+		command.entity = entity;
+		command.component = info;
+		command.data = data;
+		command.componentType = id;
+	}
+
+	template<typename T>
+	void TeEntityCommandBuffer::removeComponent(Entity entity) {
+		std::lock_guard<std::mutex> lock{ bufferMutex };
+		Command& command = commands.emplace_back();
+		command.type = CommandType::RemoveComponent;
+		command.entity = entity;
+		command.componentType = getComponentTypeId<T>();
+	}
+}
@@ -0,0 +1,26 @@
+#include "te_file.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace te {
+	std::vector<char> TeFile::read(const std::string& path) {
+		std::ifstream file{ path, std::ios::ate | std::ios::binary };
+		if (!file.is_open()) {
+			throw std::runtime_error{ "failed to open file!" + path };
+		}
+		size_t fileSize = static_cast<size_t>(file.tellg());
+		std::vector<char> buffer(fileSize);
+		file.seekg(0);
+		file.read(buffer.data(), fileSize);
+		return buffer;
+	}
+
+	void TeFile::write(const std::string& path, const std::vector<char>& data) {
+		std::ofstream file{ path, std::ios::binary };
+		if (!file.is_open()) {
+			throw std::runtime_error{ "failed to open file!" + path };
+		}
+		file.write(data.data(), data.size());
+	}
+}
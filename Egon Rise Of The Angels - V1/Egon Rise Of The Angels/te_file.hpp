@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace te {
+	// Whole-file binary IO without pulling in the renderer, so the ECS can save and load headless
+	class TeFile {
+	public:
+		static std::vector<char> read(const std::string& path);
+
+		static void write(const std::string& path, const std::vector<char>& data);
+	};
+}
@@ -8,14 +8,16 @@ namespace te {
         logMutex.lock();
         if (shouldLog) {
             printf("Has camera moved since last log: %s\n", hasMovedSinceLastLog ? "true" : "false");
+            printf("Transforms changed since last log: %zu\n", env.scene->changed<TransformComponent>(lastLogVersion).size());
+            lastLogVersion = env.scene->advanceChangeVersion();
             printf("Entities:\n");
             for (auto& entity : env.scene->getEntities()) {
                 printf("Entity: %s\n", env.scene->getEntityName(entity).c_str());
-                auto transform = env.scene->getComponent<TransformComponent>(entity);
+                auto transform = env.scene->getComponent<const TransformComponent>(entity);
                 if (transform) {
                     printf("Transform: %f %f %f\n", transform->translation.x, transform->translation.y, transform->translation.z);
                 }
-                auto mesh = env.scene->getComponent<ModelComponent>(entity);
+                auto mesh = env.scene->getComponent<const ModelComponent>(entity);
                 printf("Mesh: %s\n", mesh ? "true" : "false");
             }
 
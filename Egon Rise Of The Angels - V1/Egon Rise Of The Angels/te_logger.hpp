@@ -15,5 +15,6 @@ namespace te {
 		TheEngine& env;
 		std::mutex logMutex;
 		bool shouldLog = false;
+		uint32_t lastLogVersion = 0;
 	};
 }
\ No newline at end of file
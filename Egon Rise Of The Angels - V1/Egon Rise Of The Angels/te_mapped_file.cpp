@@ -0,0 +1,68 @@
+#include "te_mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace te {
+#ifdef _WIN32
+	TeMappedFile::TeMappedFile(const std::string& path) {
+		file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_ == INVALID_HANDLE_VALUE) {
+			file_ = nullptr;
+			throw std::runtime_error{ "failed to open file!" + path };
+		}
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(file_, &fileSize);
+		size_ = static_cast<size_t>(fileSize.QuadPart);
+		if (size_ == 0) {
+			return;
+		}
+		mapping_ = CreateFileMappingA(file_, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		data_ = mapping_ ? static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_COPY, 0, 0, 0)) : nullptr;
+		if (!data_) {
+			if (mapping_) CloseHandle(mapping_);
+			CloseHandle(file_);
+			throw std::runtime_error{ "failed to map file!" + path };
+		}
+	}
+
+	TeMappedFile::~TeMappedFile() {
+		if (data_) UnmapViewOfFile(data_);
+		if (mapping_) CloseHandle(mapping_);
+		if (file_) CloseHandle(file_);
+	}
+#else
+	TeMappedFile::TeMappedFile(const std::string& path) {
+		int file = open(path.c_str(), O_RDONLY);
+		if (file == -1) {
+			throw std::runtime_error{ "failed to open file!" + path };
+		}
+		struct stat status {};
+		fstat(file, &status);
+		size_ = static_cast<size_t>(status.st_size);
+		if (size_ > 0) {
+			void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+			data_ = data == MAP_FAILED ? nullptr : static_cast<char*>(data);
+		}
+		// The mapping keeps the file alive on its own
+		close(file);
+		if (size_ > 0 && !data_) {
+			throw std::runtime_error{ "failed to map file!" + path };
+		}
+	}
+
+	TeMappedFile::~TeMappedFile() {
+		if (data_) munmap(data_, size_);
+	}
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace te {
+	// A whole file mapped into memory, so it's paged in from the OS cache on first touch instead of
+	// being read up front. Pages are mapped copy-on-write: writing through data() only copies the
+	// pages that are touched and never changes the file
+	class TeMappedFile {
+	public:
+		TeMappedFile(const std::string& path);
+		~TeMappedFile();
+
+		TeMappedFile(const TeMappedFile&) = delete;
+		TeMappedFile& operator=(const TeMappedFile&) = delete;
+
+		// Null for an empty file
+		char* data() { return data_; }
+		size_t size() const { return size_; }
+	private:
+		char* data_ = nullptr;
+		size_t size_ = 0;
+
+#ifdef _WIN32
+		void* file_ = nullptr;
+		void* mapping_ = nullptr;
+#endif
+	};
+}
@@ -10,6 +10,7 @@
 #include <glm/gtx/hash.hpp>
 #include <unordered_map>
 #include "te_buffer.hpp"
+#include "te_async_loader.hpp"
 
 
 
@@ -137,6 +138,16 @@ namespace te {
 		return std::make_unique<te::TeModel>(device, builder);
 	}
 
+	std::future<std::shared_ptr<TeModel>> TeModel::loadModelFromFile(TeDevice& device, TeAsyncLoader& loader, const std::string& filepath) {
+		return loader.loadAsset([filepath] {
+			Builder builder{};
+			builder.loadModel(filepath);
+			return builder;
+		}, [&device](Builder& builder) {
+			return std::make_shared<TeModel>(device, builder);
+		});
+	}
+
 	void TeModel::Builder::loadModel(const std::string& filepath) {
 		tinyobj::attrib_t attrib{};
 		std::vector<tinyobj::shape_t> shapes;
@@ -7,9 +7,12 @@
 #include "te_device.hpp"
 #include "te_model.hpp"
 #include "te_buffer.hpp"
+#include <future>
 #include <memory>
 
 namespace te {
+	class TeAsyncLoader;
+
 	class TeModel {
 	public:
 		struct Vertex {
@@ -43,6 +46,9 @@ namespace te {
 
 
 		static std::unique_ptr<TeModel> createModelFromFile(TeDevice& device, const std::string& filepath);
+
+		// The file is parsed on a loader thread, the buffers are uploaded in the loader's next apply()
+		static std::future<std::shared_ptr<TeModel>> loadModelFromFile(TeDevice& device, TeAsyncLoader& loader, const std::string& filepath);
 	private:
 		TeDevice& teDevice;
 		
@@ -0,0 +1,52 @@
+#include "te_name_table.hpp"
+
+#include <mutex>
+
+namespace te {
+	TeNameTable::TeNameTable() {
+		strings.emplace_back();
+	}
+
+	TeName TeNameTable::intern(std::string_view name) {
+		if (name.empty()) {
+			return NONE;
+		}
+		tableMutex.lock_shared();
+		auto it = ids.find(name);
+		if (it != ids.end()) {
+			TeName id = it->second;
+			tableMutex.unlock_shared();
+			return id;
+		}
+		tableMutex.unlock_shared();
+
+		// Someone else may have added it between the two locks
+		tableMutex.lock();
+		it = ids.find(name);
+		if (it == ids.end()) {
+			const std::string& stored = strings.emplace_back(name);
+			it = ids.emplace(stored, static_cast<TeName>(strings.size() - 1)).first;
+		}
+		TeName id = it->second;
+		tableMutex.unlock();
+		return id;
+	}
+
+	TeName TeNameTable::find(std::string_view name) {
+		if (name.empty()) {
+			return NONE;
+		}
+		tableMutex.lock_shared();
+		auto it = ids.find(name);
+		TeName id = it != ids.end() ? it->second : NONE;
+		tableMutex.unlock_shared();
+		return id;
+	}
+
+	const std::string& TeNameTable::getString(TeName name) {
+		tableMutex.lock_shared();
+		const std::string& string = name < strings.size() ? strings[name] : strings[NONE];
+		tableMutex.unlock_shared();
+		return string;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace te {
+	// Interned string id. Equal strings always get the same id, so ids can be cached and
+	// compared instead of the strings themselves
+	using TeName = uint32_t;
+
+	// Append-only table of interned strings, safe to use from any thread. Strings are never
+	// freed, so references returned by getString stay valid for the lifetime of the table
+	class TeNameTable {
+	public:
+		static constexpr TeName NONE = 0;
+
+		TeNameTable();
+
+		TeNameTable(const TeNameTable&) = delete;
+		TeNameTable& operator=(const TeNameTable&) = delete;
+
+		// Returns the id for the string, adding it if it's new. The empty string is NONE
+		TeName intern(std::string_view name);
+
+		// Like intern, but returns NONE instead of adding strings the table hasn't seen
+		TeName find(std::string_view name);
+
+		const std::string& getString(TeName name);
+	private:
+		std::shared_mutex tableMutex;
+
+		// Indexed by TeName, a deque so the map's keys can point into it
+		std::deque<std::string> strings;
+		std::unordered_map<std::string_view, TeName> ids;
+	};
+}
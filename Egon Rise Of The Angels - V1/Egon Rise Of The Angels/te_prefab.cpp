@@ -0,0 +1,32 @@
+#include "te_prefab.hpp"
+
+#include <stdexcept>
+
+namespace te {
+	TePrefab::~TePrefab() {
+		for (auto& component : components) {
+			component.info.destroy(component.data);
+			::operator delete(component.data, std::align_val_t{ component.info.alignment });
+		}
+	}
+
+	void* TePrefab::emplace(const TeComponentInfo& info) {
+		for (auto& component : components) {
+			if (component.info.id == info.id) {
+				component.info.destroy(component.data);
+				return component.data;
+			}
+		}
+		void* data = ::operator new(info.size, std::align_val_t{ info.alignment });
+		components.push_back({ info, data });
+		return data;
+	}
+
+	TePrefab& TePrefab::addCopy(const TeComponentInfo& info, const void* component) {
+		if (!info.copyConstruct) {
+			throw std::runtime_error("prefab components have to be copyable");
+		}
+		info.copyConstruct(emplace(info), component);
+		return *this;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "te_archetype.hpp"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace te {
+	// Component holding data that many entities share by reference, like mesh refs or stats tables.
+	// Reads go straight to the shared copy, write() first gives the entity its own copy if anyone
+	// else still holds the shared one
+	template<typename T>
+	class TeShared {
+	public:
+		TeShared() : data{ std::make_shared<T>() } {}
+		explicit TeShared(T value) : data{ std::make_shared<T>(std::move(value)) } {}
+
+		const T& get() const { return *data; }
+		const T* operator->() const { return data.get(); }
+
+		T& write() {
+			if (data.use_count() > 1) {
+				data = std::make_shared<T>(*data);
+			}
+			return *data;
+		}
+
+		bool isShared() const { return data.use_count() > 1; }
+	private:
+		std::shared_ptr<T> data;
+	};
+
+	// Template for spawning many identical entities with TeScene::instantiate. Components added
+	// with add() are copied into every instance, ones added with addShared() are stored once and
+	// every instance gets a TeShared<T> referencing them
+	class TePrefab {
+	public:
+		TePrefab() = default;
+		~TePrefab();
+
+		TePrefab(const TePrefab&) = delete;
+		TePrefab& operator=(const TePrefab&) = delete;
+
+		// Replaces the prefab's component of the same type if it already has one
+		template<typename T>
+		TePrefab& add(T&& component);
+
+		template<typename T>
+		TePrefab& addShared(T&& component) {
+			return add(TeShared<std::remove_cv_t<std::remove_reference_t<T>>>(std::forward<T>(component)));
+		}
+
+		// Copies an already constructed component of the described type into the prefab
+		TePrefab& addCopy(const TeComponentInfo& info, const void* component);
+	private:
+		friend class TeScene;
+
+		struct Component {
+			TeComponentInfo info;
+			void* data;
+		};
+
+		// Returns unconstructed storage for a component, destroying the previous one of the same type
+		void* emplace(const TeComponentInfo& info);
+
+		std::vector<Component> components;
+	};
+
+	template<typename T>
+	TePrefab& TePrefab::add(T&& component) {
+		using Component = std::remove_cv_t<std::remove_reference_t<T>>;
+		static_assert(std::is_copy_constructible_v<Component>, "prefab components are copied into every instance");
+		new (emplace(TeComponentInfo::of<Component>())) Component(std::forward<T>(component));
+		return *this;
+	}
+}
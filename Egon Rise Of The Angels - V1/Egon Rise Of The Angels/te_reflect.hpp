@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace te {
+	// One named data member of T, see TE_FIELD
+	template<typename T, typename M>
+	struct TeField {
+		using Type = M;
+		const char* name;
+		M T::* member;
+	};
+
+	template<typename T, typename... Ms>
+	struct TeFieldList {
+		const char* typeName;
+		std::tuple<TeField<T, Ms>...> fields;
+	};
+
+	// Components list the members that make up their state with
+	//   static constexpr auto fields() { return teFields("Name", TE_FIELD(Name, member), ...); }
+	// and get serialization and logger text generated from it, see TeArchiveFuncs
+	template<typename T, typename... Ms>
+	constexpr TeFieldList<T, Ms...> teFields(const char* typeName, TeField<T, Ms>... fields) {
+		return { typeName, std::make_tuple(fields...) };
+	}
+
+#define TE_FIELD(Type, member) ::te::TeField<Type, decltype(Type::member)>{ #member, &Type::member }
+
+	template<typename T, typename = void>
+	struct TeHasFields : std::false_type {};
+
+	template<typename T>
+	struct TeHasFields<T, std::void_t<decltype(T::fields())>> : std::true_type {};
+
+	template<typename T, typename F>
+	void teForEachField(F&& func) {
+		constexpr auto list = T::fields();
+		std::apply([&](const auto&... field) { (func(field), ...); }, list.fields);
+	}
+
+	template<typename List>
+	struct TeFieldListTraits;
+
+	template<typename T, typename... Ms>
+	struct TeFieldListTraits<TeFieldList<T, Ms...>> {
+		// Every listed member is plain data and together they cover T without padding, so the whole
+		// object can be copied as bytes instead of field by field
+		static constexpr bool packed = std::is_trivially_copyable_v<T> && (std::is_trivially_copyable_v<Ms> && ...) && (sizeof(Ms) + ... + 0) == sizeof(T);
+	};
+
+	template<typename T>
+	inline constexpr bool teFieldsArePacked = TeFieldListTraits<decltype(T::fields())>::packed;
+
+	template<typename T>
+	struct TeIsVector : std::false_type {};
+
+	template<typename E, typename A>
+	struct TeIsVector<std::vector<E, A>> : std::true_type {};
+
+	// Fixed size math types such as glm vectors and matrices
+	template<typename T, typename = void>
+	struct TeIsIndexable : std::false_type {};
+
+	template<typename T>
+	struct TeIsIndexable<T, std::void_t<decltype(T::length()), decltype(std::declval<const T&>()[0])>> : std::true_type {};
+
+	template<typename T>
+	void teAppendFieldsText(std::string& output, const T& object);
+
+	template<typename M>
+	void teAppendText(std::string& output, const M& value) {
+		if constexpr (std::is_same_v<M, bool>) {
+			output += value ? "true" : "false";
+		}
+		else if constexpr (std::is_integral_v<M> || std::is_enum_v<M>) {
+			if constexpr (std::is_enum_v<M>) {
+				output += std::to_string(static_cast<std::underlying_type_t<M>>(value));
+			}
+			else {
+				output += std::to_string(value);
+			}
+		}
+		else if constexpr (std::is_floating_point_v<M>) {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+			output += buffer;
+		}
+		else if constexpr (std::is_same_v<M, std::string>) {
+			output += '"';
+			output += value;
+			output += '"';
+		}
+		else if constexpr (TeHasFields<M>::value) {
+			teAppendFieldsText(output, value);
+		}
+		else if constexpr (TeIsVector<M>::value || std::is_array_v<M>) {
+			output += '[';
+			bool first = true;
+			for (const auto& element : value) {
+				if (!first) output += ", ";
+				teAppendText(output, element);
+				first = false;
+			}
+			output += ']';
+		}
+		else if constexpr (TeIsIndexable<M>::value) {
+			output += '(';
+			for (decltype(M::length()) i = 0; i < M::length(); i++) {
+				if (i) output += ", ";
+				teAppendText(output, value[i]);
+			}
+			output += ')';
+		}
+		else {
+			output += "<" + std::to_string(sizeof(M)) + " bytes>";
+		}
+	}
+
+	template<typename T>
+	void teAppendFieldsText(std::string& output, const T& object) {
+		output += T::fields().typeName;
+		output += " { ";
+		bool first = true;
+		teForEachField<T>([&](const auto& field) {
+			if (!first) output += ", ";
+			output += field.name;
+			output += ": ";
+			teAppendText(output, object.*field.member);
+			first = false;
+		});
+		output += " }";
+	}
+
+	// Matches the loggerText hook signature
+	template<typename T>
+	std::string teFieldsText(void* component) {
+		std::string output;
+		teAppendFieldsText(output, *static_cast<const T*>(component));
+		return output;
+	}
+}
@@ -0,0 +1,271 @@
+#include "te_compression.hpp"
+#include "te_file.hpp"
+#include "te_scene_capture.hpp"
+#include "te_scheduler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace te {
+	TeSceneCapture::TeSceneCapture(TeScene& scene, bool copy) : scene{ &scene }, manager{ &scene.manager }, copy{ copy } {
+		for (auto& componentType : scene.componentTypes) {
+			if (!componentType || !manager->isRegisteredNOLOCK(componentType->info.id)) continue;
+			Section section{};
+			section.info = &componentType->info;
+			section.header.componentId = manager->typeToComponentId(componentType->info.id);
+			section.header.elementSize = section.info->trivial ? section.info->size : 0;
+			section.archive = manager->getRegisteredComponents()[section.header.componentId].archive;
+			if (section.info->trivial || section.archive.write) {
+				sections.push_back(section);
+			}
+		}
+
+		// Chunks are blocks as they are, pools are cut into blocks of BLOCK_COMPONENTS
+		for (size_t s = 0; s < sections.size(); s++) {
+			TeComponentPool* pool = scene.getPoolNOLOCK(sections[s].info->id);
+			if (!pool) continue;
+			size_t begin = blocks.size();
+			for (size_t first = 0; first < pool->size(); first += BLOCK_COMPONENTS) {
+				Block& block = blocks.emplace_back();
+				block.pool = pool;
+				block.first = first;
+				block.count = std::min(pool->size() - first, BLOCK_COMPONENTS);
+				block.pieces.emplace_back().section = s;
+				sections[s].header.count += block.count;
+			}
+			blockRanges[pool] = { begin, blocks.size() };
+		}
+		for (auto& [signature, archetype] : scene.archetypes) {
+			for (TeChunk* chunk : archetype->getChunks()) {
+				if (chunk->count == 0) continue;
+				blockRanges[chunk] = { blocks.size(), blocks.size() + 1 };
+				Block& block = blocks.emplace_back();
+				block.chunk = chunk;
+				block.count = chunk->count;
+			}
+		}
+
+		// Pieces go in archetype order within each section, the same order a live save writes
+		for (size_t s = 0; s < sections.size(); s++) {
+			if (scene.getPoolNOLOCK(sections[s].info->id)) continue;
+			for (auto& [signature, archetype] : scene.archetypes) {
+				int column = archetype->getColumn(sections[s].info->id);
+				if (column == -1) continue;
+				for (TeChunk* chunk : archetype->getChunks()) {
+					if (chunk->count == 0) continue;
+					Piece& piece = blocks[blockRanges[chunk].first].pieces.emplace_back();
+					piece.section = s;
+					piece.column = column;
+					sections[s].header.count += chunk->count;
+				}
+			}
+		}
+		remainingBlocks = blocks.size() + 1;
+	}
+
+	void TeSceneCapture::preserve(Block& block) {
+		if (block.preserved.load()) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(block.mutex);
+		if (block.preserved.load()) {
+			return;
+		}
+
+		block.entities = block.chunk ? block.chunk->entities : block.pool->getEntities() + block.first;
+		if (copy) {
+			block.entityCopy.assign(block.entities, block.entities + block.count);
+			block.entities = block.entityCopy.data();
+		}
+		for (Piece& piece : block.pieces) {
+			const Section& section = sections[piece.section];
+			size_t size = section.info->size;
+			const char* source = block.chunk ? block.chunk->columns[piece.column] : block.pool->getData() + block.first * size;
+			if (section.info->trivial) {
+				piece.size = block.count * size;
+				if (copy) {
+					piece.bytes.assign(source, source + piece.size);
+					source = piece.bytes.data();
+				}
+				piece.data = source;
+				continue;
+			}
+			TeArchiveWriter writer{ piece.bytes };
+			for (size_t i = 0; i < block.count; i++) {
+				size_t sizeOffset = writer.reserve<uint64_t>();
+				section.archive.write(source + i * size, writer);
+				writer.patch<uint64_t>(sizeOffset, writer.size() - sizeOffset - sizeof(uint64_t));
+			}
+			piece.data = piece.bytes.data();
+			piece.size = piece.bytes.size();
+		}
+		block.preserved.store(true);
+		blockPreserved();
+	}
+
+	void TeSceneCapture::preserve(const void* storage, size_t position) {
+		auto range = blockRanges.find(storage);
+		if (range == blockRanges.end()) {
+			return;
+		}
+		auto [begin, end] = range->second;
+		if (position != SIZE_MAX && begin + position / BLOCK_COMPONENTS < end) {
+			begin += position / BLOCK_COMPONENTS;
+			end = begin + 1;
+		}
+		for (size_t b = begin; b < end; b++) {
+			preserve(blocks[b]);
+		}
+	}
+
+	void TeSceneCapture::preserveEntities() {
+		std::lock_guard<std::mutex> lock(entityMutex);
+		if (entitiesPreserved) {
+			return;
+		}
+		tableIndices.assign(scene->entityRecords.size(), 0);
+		for (uint32_t index = 0; index < scene->entityRecords.size(); index++) {
+			if (!scene->entityRecords[index].archetype) continue;
+			tableIndices[index] = static_cast<uint32_t>(handles.size());
+			handles.push_back({ index, scene->entityRecords[index].generation });
+			names.push_back(scene->entityNames[index]);
+		}
+		entitiesPreserved = true;
+		blockPreserved();
+	}
+
+	void TeSceneCapture::preserveAll(TeWorkerPool* workers) {
+		preserveEntities();
+		TeWorkerPool::forEach(workers, blocks.size(), [this](size_t b) { preserve(blocks[b]); });
+	}
+
+	void TeSceneCapture::blockPreserved() {
+		// Nothing of the scene is read after this, so it's fine for the scene to go away right after
+		if (--remainingBlocks == 0 && copy) {
+			scene->capturing.store(false);
+		}
+	}
+
+	void TeSceneCapture::saveSnapshot(TeArchiveWriter& writer, TeWorkerPool* workers) {
+		if (saved) {
+			throw std::runtime_error("scene capture was already saved");
+		}
+		saved = true;
+		preserveAll(workers);
+
+		TeNameTable& nameTable = manager->getNameTable();
+		TeSnapshotHeader header{};
+		header.entityCount = handles.size();
+		size_t start = writer.size();
+		size_t headerOffset = writer.reserve<TeSnapshotHeader>();
+		for (TeName name : names) {
+			uint32_t length = static_cast<uint32_t>(nameTable.getString(name).size());
+			writer.write(length);
+			header.nameBytes += length;
+		}
+		writer.write(handles.data(), handles.size() * sizeof(TeEntity));
+		for (TeName name : names) {
+			const std::string& string = nameTable.getString(name);
+			writer.write(string.data(), string.size());
+		}
+
+		// Lay out every section, then let each block fill in its own indices and data
+		struct Placement {
+			size_t indexOffset;
+			size_t blobOffset;
+		};
+		std::vector<std::vector<std::pair<Block*, Piece*>>> sectionPieces(sections.size());
+		for (Block& block : blocks) {
+			for (Piece& piece : block.pieces) {
+				sectionPieces[piece.section].push_back({ &block, &piece });
+			}
+		}
+		std::vector<Placement> placements;
+		std::vector<std::pair<Block*, Piece*>> pieces;
+		for (size_t s = 0; s < sections.size(); s++) {
+			Section& section = sections[s];
+			if (section.header.count == 0) continue;
+			size_t sectionOffset = writer.reserve<TeSnapshotComponentHeader>();
+			size_t indexOffset = writer.reserve(static_cast<size_t>(section.header.count) * sizeof(uint32_t));
+			writer.align(TeSnapshotHeader::BLOB_ALIGNMENT, start);
+			size_t blobOffset = writer.size();
+			for (auto& [block, piece] : sectionPieces[s]) {
+				placements.push_back({ indexOffset, writer.size() });
+				pieces.push_back({ block, piece });
+				indexOffset += block->count * sizeof(uint32_t);
+				writer.reserve(piece->size);
+			}
+			section.header.blobBytes = writer.size() - blobOffset;
+			writer.patch(sectionOffset, section.header);
+			header.componentTypeCount++;
+		}
+		writer.patch(headerOffset, header);
+
+		char* output = writer.data();
+		TeWorkerPool::forEach(workers, pieces.size(), [&](size_t p) {
+			auto [block, piece] = pieces[p];
+			char* indices = output + placements[p].indexOffset;
+			for (size_t i = 0; i < block->count; i++) {
+				std::memcpy(indices + i * sizeof(uint32_t), &tableIndices[block->entities[i].index], sizeof(uint32_t));
+			}
+			if (piece->size) {
+				std::memcpy(output + placements[p].blobOffset, piece->data, piece->size);
+			}
+			std::vector<char>().swap(piece->bytes);
+		});
+	}
+
+	std::vector<char> TeSceneCapture::saveSnapshot(TeWorkerPool* workers) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		saveSnapshot(writer, workers);
+		return output;
+	}
+
+	void TeSceneCapture::saveSnapshotToFile(const std::string& path, TeWorkerPool* workers, bool compressed) {
+		std::vector<char> snapshot = saveSnapshot(workers);
+		if (compressed) {
+			snapshot = TeCompression::compress(snapshot, workers);
+		}
+		TeFile::write(path, snapshot);
+	}
+
+	std::shared_ptr<TeSceneCapture> TeScene::capture() {
+		manager.getMutex().lock();
+		try {
+			lockForWrite();
+		}
+		catch (...) {
+			manager.getMutex().unlock();
+			throw;
+		}
+		detachCaptureNOLOCK();
+		std::shared_ptr<TeSceneCapture> capture{ new TeSceneCapture(*this, true) };
+		manager.getMutex().unlock();
+		activeCapture = capture;
+		capturing = true;
+		sceneMutex.unlock();
+		return capture;
+	}
+
+	void TeScene::preserveForCaptureNOLOCK(const void* storage, size_t position) {
+		activeCapture->preserve(storage, position);
+	}
+
+	void TeScene::preserveEntitiesForCaptureNOLOCK() {
+		activeCapture->preserveEntities();
+	}
+
+	void TeScene::detachCaptureNOLOCK() {
+		if (!activeCapture) {
+			return;
+		}
+		// Nobody else holds the capture, so nothing will ever read what it hasn't preserved yet
+		if (activeCapture.use_count() > 1) {
+			activeCapture->preserveAll(nullptr);
+		}
+		activeCapture.reset();
+		capturing = false;
+	}
+}
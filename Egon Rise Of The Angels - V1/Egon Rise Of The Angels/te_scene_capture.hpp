@@ -0,0 +1,106 @@
+#pragma once
+
+#include "te_ecs.hpp"
+#include "te_snapshot.hpp"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace te {
+	// The state of a scene at one point in time, written out as a snapshot (see te_snapshot.hpp).
+	// TeScene::capture only records which chunks and pools hold the scene, each one is copied the
+	// first time something is about to write to it, or when the capture is saved, whichever comes
+	// first. Saving can then run on any thread while the scene keeps changing
+	class TeSceneCapture {
+	public:
+		TeSceneCapture(const TeSceneCapture&) = delete;
+		TeSceneCapture& operator=(const TeSceneCapture&) = delete;
+
+		// With workers, blocks are copied and serialized in parallel. Can only be saved once
+		void saveSnapshot(TeArchiveWriter& writer, TeWorkerPool* workers = nullptr);
+
+		std::vector<char> saveSnapshot(TeWorkerPool* workers = nullptr);
+
+		void saveSnapshotToFile(const std::string& path, TeWorkerPool* workers = nullptr, bool compressed = false);
+
+		// Blocks and the entity table not copied yet, the scene stops tracking writes for the capture
+		// once this reaches zero
+		size_t getRemainingBlocks() const { return remainingBlocks.load(); }
+	private:
+		friend class TeScene;
+
+		// A chunk, or up to BLOCK_COMPONENTS components of a pool
+		static constexpr size_t BLOCK_COMPONENTS = 16 * 1024;
+
+		// One component type's part of a block
+		struct Piece {
+			size_t section = 0;
+			// Chunk column, unused for pools
+			int column = -1;
+			// Raw components or framed serialized ones, see te_snapshot.hpp
+			const char* data = nullptr;
+			size_t size = 0;
+			std::vector<char> bytes;
+		};
+
+		struct Block {
+			TeChunk* chunk = nullptr;
+			TeComponentPool* pool = nullptr;
+			size_t first = 0;
+			size_t count = 0;
+			std::vector<Piece> pieces;
+
+			std::mutex mutex;
+			std::atomic<bool> preserved{ false };
+			const TeEntity* entities = nullptr;
+			std::vector<TeEntity> entityCopy;
+		};
+
+		struct Section {
+			TeSnapshotComponentHeader header;
+			const TeComponentInfo* info;
+			TeArchiveFuncs archive;
+		};
+
+		// Records the scene's blocks, the scene has to be locked. A capture that copies lets go of
+		// the scene's memory as blocks are preserved, one that doesn't reads it in place and is only
+		// valid while the scene stays locked
+		TeSceneCapture(TeScene& scene, bool copy);
+
+		// Makes the block independent of later writes to the scene, a no-op once it already is
+		void preserve(Block& block);
+
+		// Preserves whatever a write to the chunk or pool could change, for a pool only the block
+		// holding the component at position unless it's SIZE_MAX
+		void preserve(const void* storage, size_t position);
+
+		void preserveEntities();
+
+		void preserveAll(TeWorkerPool* workers);
+
+		// The last block to be preserved ends the capture's hold on the scene
+		void blockPreserved();
+
+		// The scene is only used until every block is preserved, the manager until the capture is saved
+		TeScene* scene;
+		TeECS* manager;
+		bool copy;
+		std::vector<Section> sections;
+		std::deque<Block> blocks;
+		// Blocks belonging to each chunk and pool
+		std::unordered_map<const void*, std::pair<size_t, size_t>> blockRanges;
+		std::atomic<size_t> remainingBlocks{ 0 };
+		bool saved = false;
+
+		// Entity table, in index order
+		std::mutex entityMutex;
+		bool entitiesPreserved = false;
+		std::vector<uint32_t> tableIndices;
+		std::vector<TeEntity> handles;
+		std::vector<TeName> names;
+	};
+}
@@ -0,0 +1,221 @@
+#include "te_scheduler.hpp"
+
+#include <algorithm>
+
+namespace te {
+	TeWorkerPool::TeWorkerPool(size_t threadCount) {
+		if (threadCount == 0) {
+			unsigned int cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1 ? cores - 1 : 1;
+		}
+		threads.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; i++) {
+			threads.emplace_back(&TeWorkerPool::threadFunction, this);
+		}
+	}
+
+	TeWorkerPool::~TeWorkerPool() {
+		poolMutex.lock();
+		shuttingDown = true;
+		poolMutex.unlock();
+		poolCondition.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void TeWorkerPool::submit(std::function<void()> task) {
+		poolMutex.lock();
+		tasks.push_back(std::move(task));
+		poolMutex.unlock();
+		poolCondition.notify_one();
+	}
+
+	void TeWorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& func) {
+		// Helpers can start after every index is taken, so what they touch outlives this call
+		struct State {
+			const std::function<void(size_t)>* func;
+			size_t count;
+			std::atomic<size_t> next{ 0 };
+			std::mutex mutex;
+			std::condition_variable condition;
+			size_t done = 0;
+			std::exception_ptr firstException;
+			const std::vector<TeComponentTypeId>* writes;
+		};
+		auto state = std::make_shared<State>();
+		state->func = &func;
+		state->count = count;
+		state->writes = TeWriteAccess::getCurrent();
+		auto work = [](State& state) {
+			for (size_t i = state.next++; i < state.count; i = state.next++) {
+				std::exception_ptr exception;
+				try {
+					(*state.func)(i);
+				}
+				catch (...) {
+					exception = std::current_exception();
+				}
+				state.mutex.lock();
+				if (exception && !state.firstException) {
+					state.firstException = exception;
+				}
+				if (++state.done == state.count) {
+					state.condition.notify_all();
+				}
+				state.mutex.unlock();
+			}
+		};
+
+		size_t helpers = std::min(threads.size(), count > 0 ? count - 1 : 0);
+		for (size_t i = 0; i < helpers; i++) {
+			submit([state, work] {
+				TeWriteAccess access{ state->writes };
+				work(*state);
+			});
+		}
+		work(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->condition.wait(lock, [&state] { return state->done == state->count; });
+		if (state->firstException) {
+			std::rethrow_exception(state->firstException);
+		}
+	}
+
+	void TeWorkerPool::forEach(TeWorkerPool* workers, size_t count, const std::function<void(size_t)>& func) {
+		if (workers) {
+			workers->parallelFor(count, func);
+			return;
+		}
+		for (size_t i = 0; i < count; i++) {
+			func(i);
+		}
+	}
+
+	void TeWorkerPool::threadFunction() {
+		std::unique_lock<std::mutex> lock(poolMutex);
+		while (true) {
+			poolCondition.wait(lock, [this] { return shuttingDown || !tasks.empty(); });
+			if (tasks.empty()) {
+				return;
+			}
+			std::function<void()> task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			task();
+			lock.lock();
+		}
+	}
+
+	static bool intersects(const std::vector<TeComponentTypeId>& a, const std::vector<TeComponentTypeId>& b) {
+		for (TeComponentTypeId id : a) {
+			if (std::find(b.begin(), b.end(), id) != b.end()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool TeSystem::conflictsWith(const TeSystem& other) const {
+		return intersects(writeSet, other.readSet) || intersects(writeSet, other.writeSet) || intersects(readSet, other.writeSet);
+	}
+
+	TeSystem& TeSystemScheduler::addSystem(std::string name, std::function<void()> func) {
+		systems.push_back(std::make_unique<TeSystem>(std::move(name), std::move(func)));
+		return *systems.back();
+	}
+
+	void TeSystemScheduler::buildGraph() {
+		dependents.assign(systems.size(), {});
+		dependencyCounts.assign(systems.size(), 0);
+		for (size_t later = 0; later < systems.size(); later++) {
+			for (size_t earlier = 0; earlier < later; earlier++) {
+				if (systems[later]->conflictsWith(*systems[earlier])) {
+					dependents[earlier].push_back(later);
+					dependencyCounts[later]++;
+				}
+			}
+		}
+		graphSize = systems.size();
+	}
+
+	void TeSystemScheduler::run(TeScene& scene) {
+		if (graphSize != systems.size()) {
+			buildGraph();
+		}
+		if (systems.empty()) {
+			return;
+		}
+
+		TeReadPhase phase{ scene };
+		scene.systemsRunning = true;
+		std::unique_lock<std::mutex> lock(runMutex);
+		pendingDependencies = dependencyCounts;
+		remainingSystems = systems.size();
+		firstException = nullptr;
+		for (size_t system = 0; system < systems.size(); system++) {
+			if (pendingDependencies[system] == 0) {
+				dispatchNOLOCK(system, phase);
+			}
+		}
+
+		// The calling thread runs main thread systems as they become ready and otherwise waits
+		while (remainingSystems > 0) {
+			runCondition.wait(lock, [this] { return remainingSystems == 0 || !mainThreadQueue.empty(); });
+			while (!mainThreadQueue.empty()) {
+				size_t system = mainThreadQueue.front();
+				mainThreadQueue.pop_front();
+				lock.unlock();
+				execute(system, phase);
+				lock.lock();
+			}
+		}
+
+		std::exception_ptr exception = firstException;
+		firstException = nullptr;
+		lock.unlock();
+		scene.systemsRunning = false;
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void TeSystemScheduler::dispatchNOLOCK(size_t system, TeReadPhase& phase) {
+		if (systems[system]->mainThread) {
+			mainThreadQueue.push_back(system);
+			runCondition.notify_all();
+			return;
+		}
+		workerPool.submit([this, system, &phase] {
+			TeReadPhase joined = TeReadPhase::join(phase);
+			execute(system, phase);
+		});
+	}
+
+	void TeSystemScheduler::execute(size_t system, TeReadPhase& phase) {
+		std::exception_ptr exception;
+		try {
+			TeWriteAccess access{ &systems[system]->writeSet };
+			systems[system]->func();
+		}
+		catch (...) {
+			exception = std::current_exception();
+		}
+
+		runMutex.lock();
+		if (exception && !firstException) {
+			firstException = exception;
+		}
+		for (size_t dependent : dependents[system]) {
+			if (--pendingDependencies[dependent] == 0) {
+				dispatchNOLOCK(dependent, phase);
+			}
+		}
+		remainingSystems--;
+
+		// Notify before unlocking, run() can return and the scheduler go away as soon as the lock is free
+		runCondition.notify_all();
+		runMutex.unlock();
+	}
+}
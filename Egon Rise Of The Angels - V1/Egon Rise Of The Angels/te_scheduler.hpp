@@ -0,0 +1,127 @@
+#pragma once
+
+#include "te_ecs.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace te {
+	// Fixed set of threads pulling tasks off a shared queue
+	class TeWorkerPool {
+	public:
+		// Defaults to one thread per core, leaving one for the thread that submits work
+		TeWorkerPool(size_t threadCount = 0);
+		~TeWorkerPool();
+
+		TeWorkerPool(const TeWorkerPool&) = delete;
+		TeWorkerPool& operator=(const TeWorkerPool&) = delete;
+
+		void submit(std::function<void()> task);
+
+		// Calls func for every index below count, spread over the pool with the calling thread taking
+		// part, and returns once all of them are done. Safe to call from one of the pool's own tasks.
+		// Rethrows the first exception func threw
+		void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+		// parallelFor on workers if there are any, otherwise a plain loop on the calling thread
+		static void forEach(TeWorkerPool* workers, size_t count, const std::function<void(size_t)>& func);
+
+		size_t getThreadCount() const { return threads.size(); }
+	private:
+		void threadFunction();
+
+		std::vector<std::thread> threads;
+		std::deque<std::function<void()>> tasks;
+		std::mutex poolMutex;
+		std::condition_variable poolCondition;
+		bool shuttingDown = false;
+	};
+
+	// A unit of per-frame work with the components and resources it touches declared up front.
+	// Any type works as a resource key, e.g. reads<TeCamera>() for state that isn't a component
+	class TeSystem {
+	public:
+		TeSystem(std::string name, std::function<void()> func) : name{ std::move(name) }, func{ std::move(func) } {}
+
+		template<typename... Ts>
+		TeSystem& reads() {
+			(readSet.push_back(getComponentTypeId<Ts>()), ...);
+			return *this;
+		}
+
+		template<typename... Ts>
+		TeSystem& writes() {
+			(writeSet.push_back(getComponentTypeId<Ts>()), ...);
+			return *this;
+		}
+
+		// For systems that have to run on the thread that calls TeSystemScheduler::run, like
+		// anything using GLFW input
+		TeSystem& onMainThread() {
+			mainThread = true;
+			return *this;
+		}
+
+		// Two systems conflict if either writes something the other reads or writes
+		bool conflictsWith(const TeSystem& other) const;
+
+		const std::string& getName() const { return name; }
+	private:
+		friend class TeSystemScheduler;
+
+		std::string name;
+		std::function<void()> func;
+		std::vector<TeComponentTypeId> readSet;
+		std::vector<TeComponentTypeId> writeSet;
+		bool mainThread = false;
+	};
+
+	// Runs registered systems once per call, concurrently where their declared access allows.
+	// A system depends on every earlier registered system it conflicts with, so conflicting
+	// systems keep their registration order and everything else overlaps on the worker pool
+	class TeSystemScheduler {
+	public:
+		TeSystemScheduler(TeWorkerPool& workerPool) : workerPool{ workerPool } {}
+
+		// Declare the system's access on the returned reference before the next run
+		TeSystem& addSystem(std::string name, std::function<void()> func);
+
+		// Runs every system once inside a read phase of the scene, so systems may read and write
+		// component data but structural changes have to go through a TeEntityCommandBuffer. A system
+		// may only take non-const access to the components it declared with writes<>().
+		// Rethrows the first exception a system threw once every system has finished
+		void run(TeScene& scene);
+	private:
+		void buildGraph();
+
+		// Queues the system on the worker pool, or for the calling thread if it's main thread only
+		void dispatchNOLOCK(size_t system, TeReadPhase& phase);
+
+		void execute(size_t system, TeReadPhase& phase);
+
+		TeWorkerPool& workerPool;
+
+		std::vector<std::unique_ptr<TeSystem>> systems;
+
+		// Dependency graph, rebuilt when systems are added
+		std::vector<std::vector<size_t>> dependents;
+		std::vector<size_t> dependencyCounts;
+		size_t graphSize = 0;
+
+		// State of the current run
+		std::mutex runMutex;
+		std::condition_variable runCondition;
+		std::vector<size_t> pendingDependencies;
+		std::deque<size_t> mainThreadQueue;
+		size_t remainingSystems = 0;
+		std::exception_ptr firstException;
+	};
+}
@@ -0,0 +1,276 @@
+#include "te_compression.hpp"
+#include "te_ecs.hpp"
+#include "te_file.hpp"
+#include "te_mapped_file.hpp"
+#include "te_scene_capture.hpp"
+#include "te_scheduler.hpp"
+#include "te_snapshot.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace te {
+	TeSnapshotView::TeSnapshotView(const char* data, size_t size) {
+		TeArchiveReader reader{ data, size };
+		header = reader.read<TeSnapshotHeader>();
+		if (header.magic != TeSnapshotHeader::MAGIC || header.version != TeSnapshotHeader::VERSION) {
+			throw std::runtime_error("not a scene snapshot or saved by an unsupported version");
+		}
+		if (header.entityCount > size / sizeof(uint32_t)) {
+			throw std::runtime_error("snapshot is truncated");
+		}
+		size_t entityCount = static_cast<size_t>(header.entityCount);
+
+		const char* lengths = reader.read(entityCount * sizeof(uint32_t));
+		handles = reader.read(entityCount * sizeof(TeEntity));
+		names = reader.read(static_cast<size_t>(header.nameBytes));
+		nameOffsets.resize(entityCount + 1);
+		for (size_t i = 0; i < entityCount; i++) {
+			uint32_t length;
+			std::memcpy(&length, lengths + i * sizeof(uint32_t), sizeof(uint32_t));
+			if (length > header.nameBytes - nameOffsets[i]) {
+				throw std::runtime_error("snapshot entity names are corrupt");
+			}
+			nameOffsets[i + 1] = nameOffsets[i] + length;
+		}
+
+		sections.resize(static_cast<size_t>(std::min<uint64_t>(header.componentTypeCount, size / sizeof(TeSnapshotComponentHeader))));
+		if (sections.size() != header.componentTypeCount) {
+			throw std::runtime_error("snapshot is truncated");
+		}
+		// Loading places each component exactly once, so an entity or a component type showing up
+		// twice would construct over a live component
+		std::vector<bool> seenEntities;
+		std::unordered_set<uint64_t> seenComponents;
+		for (Section& section : sections) {
+			section.header = reader.read<TeSnapshotComponentHeader>();
+			if (!seenComponents.insert(section.header.componentId).second) {
+				throw std::runtime_error("snapshot is corrupt, it has two sections for a component type");
+			}
+			if (section.header.count > size / sizeof(uint32_t)) {
+				throw std::runtime_error("snapshot is truncated");
+			}
+			section.indices = reader.read(static_cast<size_t>(section.header.count) * sizeof(uint32_t));
+			reader.align(TeSnapshotHeader::BLOB_ALIGNMENT);
+			section.blobOffset = reader.getOffset();
+			section.blob = reader.read(static_cast<size_t>(section.header.blobBytes));
+			seenEntities.assign(entityCount, false);
+			for (size_t i = 0; i < section.header.count; i++) {
+				uint32_t entity = getEntity(section, i);
+				if (entity >= entityCount) {
+					throw std::runtime_error("snapshot component belongs to an entity that doesn't exist");
+				}
+				if (seenEntities[entity]) {
+					throw std::runtime_error("snapshot is corrupt, an entity has the same component twice");
+				}
+				seenEntities[entity] = true;
+			}
+			if (section.header.elementSize && section.header.blobBytes != section.header.count * section.header.elementSize) {
+				throw std::runtime_error("snapshot component blob has the wrong size");
+			}
+			// Every serialized component is framed by its size, so the blob bounds how many there can
+			// be before loading allocates count of them
+			if (!section.header.elementSize && section.header.count > section.header.blobBytes / sizeof(uint64_t)) {
+				throw std::runtime_error("snapshot component blob is too small for its component count");
+			}
+		}
+	}
+
+	TeEntity TeSnapshotView::getHandle(size_t entity) const {
+		TeEntity handle;
+		std::memcpy(&handle, handles + entity * sizeof(TeEntity), sizeof(TeEntity));
+		return handle;
+	}
+
+	uint32_t TeSnapshotView::getEntity(const Section& section, size_t i) {
+		uint32_t index;
+		std::memcpy(&index, section.indices + i * sizeof(uint32_t), sizeof(uint32_t));
+		return index;
+	}
+
+	std::vector<char> TeScene::saveSnapshot(TeWorkerPool* workers) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		saveSnapshot(writer, workers);
+		return output;
+	}
+
+	void TeScene::saveSnapshot(TeArchiveWriter& writer, TeWorkerPool* workers) {
+		// A capture that reads the scene in place. Systems declared with writes<>() write components
+		// under the shared lock, so only the exclusive one keeps it consistent until it's written
+		if (inReadPhase()) {
+			throw std::runtime_error("scene snapshot inside a read phase, save it outside the phase or from a capture");
+		}
+		manager.getMutex().lock();
+		std::unique_lock<std::shared_mutex> lock{ sceneMutex };
+		TeSceneCapture capture{ *this, false };
+		manager.getMutex().unlock();
+		capture.saveSnapshot(writer, workers);
+	}
+
+	std::vector<TeScene::Entity> TeScene::loadSnapshot(const char* data, size_t size) {
+		return loadSnapshot(data, size, nullptr);
+	}
+
+	std::vector<TeScene::Entity> TeScene::restoreSnapshot(const char* data, size_t size) {
+		return loadSnapshot(data, size, nullptr, true);
+	}
+
+	std::vector<TeScene::Entity> TeScene::loadSnapshot(const char* data, size_t size, const std::shared_ptr<TeMappedFile>& mapping, bool replace) {
+		TeSnapshotView view{ data, size };
+		size_t entityCount = view.getEntityCount();
+
+		// Everything is validated before the scene is locked, so a bad snapshot leaves it untouched
+		struct Section {
+			const TeSnapshotView::Section* view;
+			TeECS::RegisteredComponent registered;
+			// Components that aren't stored as raw bytes, read ahead of locking the scene
+			std::unique_ptr<TeComponentArray> staged;
+		};
+		std::vector<Section> sections(view.getSections().size());
+		for (size_t s = 0; s < sections.size(); s++) {
+			sections[s].view = &view.getSections()[s];
+		}
+
+		manager.getMutex().lock();
+		bool registered = true;
+		for (Section& section : sections) {
+			if (section.view->header.componentId >= manager.getRegisteredComponents().size()) {
+				registered = false;
+				break;
+			}
+			section.registered = manager.getRegisteredComponents()[section.view->header.componentId];
+		}
+		manager.getMutex().unlock();
+		if (!registered) {
+			throw std::runtime_error("snapshot has a component that isn't registered");
+		}
+		for (Section& section : sections) {
+			const TeComponentInfo& info = section.registered.componentInfo;
+			if (section.view->header.elementSize) {
+				if (!info.trivial || section.view->header.elementSize != info.size) {
+					throw std::runtime_error("snapshot component layout doesn't match its registration");
+				}
+				continue;
+			}
+			if (!section.registered.archive.read) {
+				throw std::runtime_error("snapshot has a component that can't be deserialized");
+			}
+			section.staged = std::make_unique<TeComponentArray>(info, static_cast<size_t>(section.view->header.count));
+			TeArchiveReader blob{ section.view->blob, static_cast<size_t>(section.view->header.blobBytes) };
+			for (size_t i = 0; i < section.view->header.count; i++) {
+				TeArchiveReader component = blob.readArchive(static_cast<size_t>(blob.read<uint64_t>()));
+				section.staged->read(section.registered.archive.read, component);
+			}
+		}
+
+		// The name table only grows, so names wait until the snapshot is known to be good. It has its
+		// own lock, so they're still interned before the scene is locked
+		std::vector<TeName> entityNameIds(entityCount);
+		for (size_t i = 0; i < entityCount; i++) {
+			entityNameIds[i] = manager.getNameTable().intern(view.getName(i));
+		}
+
+		lockForWrite();
+		std::unique_lock<std::shared_mutex> lock{ sceneMutex, std::adopt_lock };
+		if (replace) {
+			for (uint32_t index = 0; index < entityRecords.size(); index++) {
+				if (entityRecords[index].archetype) {
+					destroyEntityNOLOCK({ index, entityRecords[index].generation });
+				}
+			}
+		}
+
+		// Work out every entity's final archetype first, so each one is placed exactly once
+		std::vector<const TeComponentInfo*> infos(sections.size());
+		std::vector<TeArchetype*> targets(entityCount, emptyArchetype);
+		for (size_t s = 0; s < sections.size(); s++) {
+			infos[s] = getComponentInfoNOLOCK(sections[s].registered.componentInfo);
+			if (infos[s]->storage != TeStoragePolicy::Archetype) continue;
+			for (size_t i = 0; i < sections[s].view->header.count; i++) {
+				TeArchetype*& target = targets[TeSnapshotView::getEntity(*sections[s].view, i)];
+				if (target->getColumn(infos[s]->id) == -1) {
+					target = getArchetypeWithNOLOCK(target, infos[s]);
+				}
+			}
+		}
+
+		reserveEntitiesNOLOCK(entityCount);
+		std::vector<Entity> output(entityCount);
+		for (size_t i = 0; i < entityCount; i++) {
+			output[i] = allocateEntityNOLOCK();
+			setEntityNameNOLOCK(output[i], entityNameIds[i]);
+			EntityRecord& record = entityRecords[output[i].index];
+			record.archetype = targets[i];
+			record.location = targets[i]->allocateRow(output[i]);
+		}
+
+		uint32_t version = getChangeVersion();
+		for (size_t s = 0; s < sections.size(); s++) {
+			const Section& section = sections[s];
+			const TeComponentInfo* info = infos[s];
+			TeComponentPool* pool = getPoolNOLOCK(info->id);
+			char* mapped = mapping ? mapping->data() + section.view->blobOffset : nullptr;
+			if (pool) {
+				preparePoolReserveNOLOCK(pool, pool->size() + static_cast<size_t>(section.view->header.count));
+			}
+			if (pool && mapped && pool->size() == 0 && section.view->header.elementSize && reinterpret_cast<uintptr_t>(mapped) % info->alignment == 0) {
+				// Components are emplaced in blob order, so each one lands on its own bytes in the mapping
+				// and is only copied if a page of it is written to
+				pool->borrow(mapped, static_cast<size_t>(section.view->header.count), mapping);
+			}
+			else if (pool) {
+				pool->reserve(pool->size() + static_cast<size_t>(section.view->header.count));
+			}
+			const char* blob = section.view->blob;
+			for (size_t i = 0; i < section.view->header.count; i++) {
+				Entity entity = output[TeSnapshotView::getEntity(*section.view, i)];
+				EntityRecord& record = entityRecords[entity.index];
+				int column = pool ? -1 : record.archetype->getColumn(info->id);
+				void* slot = pool ? pool->allocate(entity) : record.archetype->getComponent(record.location, column);
+
+				if (section.view->header.elementSize) {
+					if (slot != blob) {
+						std::memcpy(slot, blob, info->size);
+					}
+					blob += info->size;
+				}
+				else {
+					info->moveConstruct(slot, section.staged->get(i));
+				}
+
+				if (pool) {
+					pool->commit(entity);
+					pool->markChanged(entity, version);
+				}
+				else {
+					record.archetype->markChanged(record.location, column, version);
+				}
+			}
+		}
+
+		if (logging) {
+			printf("Loaded %zu entities from snapshot\n", entityCount);
+		}
+		return output;
+	}
+
+	void TeScene::saveSnapshotToFile(const std::string& path, TeWorkerPool* workers, bool compressed) {
+		std::vector<char> snapshot = saveSnapshot(workers);
+		if (compressed) {
+			snapshot = TeCompression::compress(snapshot, workers);
+		}
+		TeFile::write(path, snapshot);
+	}
+
+	std::vector<TeScene::Entity> TeScene::loadSnapshotFromFile(const std::string& path, TeWorkerPool* workers) {
+		auto mapping = std::make_shared<TeMappedFile>(path);
+		if (TeCompression::isCompressed(mapping->data(), mapping->size())) {
+			return loadSnapshot(TeCompression::decompress(mapping->data(), mapping->size(), workers));
+		}
+		return loadSnapshot(mapping->data(), mapping->size(), mapping);
+	}
+}
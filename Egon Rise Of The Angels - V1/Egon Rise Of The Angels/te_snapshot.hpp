@@ -0,0 +1,70 @@
+#pragma once
+
+#include "te_archetype.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace te {
+	// Layout of a whole-scene snapshot from TeScene::saveSnapshot, in the byte order of the machine
+	// that wrote it:
+	//   TeSnapshotHeader
+	//   entity table: a uint32_t name length per entity, the TeEntity handle each one had in the
+	//   saved scene, then all of the names back to back
+	//   per component type: TeSnapshotComponentHeader, a uint32_t entity table index per
+	//   instance, zero padding up to BLOB_ALIGNMENT from the start of the snapshot, then the blob
+	// Trivially copyable components are stored as their raw bytes one after another, anything else
+	// as a uint64_t size followed by the output of its registered serialize function. Aligned blobs
+	// let a memory-mapped snapshot be used as component storage as is
+	struct TeSnapshotHeader {
+		static constexpr uint32_t MAGIC = 0x4e534554; // "TESN"
+		static constexpr uint32_t VERSION = 3;
+		static constexpr size_t BLOB_ALIGNMENT = 64;
+
+		uint32_t magic = MAGIC;
+		uint32_t version = VERSION;
+		uint64_t entityCount = 0;
+		uint64_t nameBytes = 0;
+		uint64_t componentTypeCount = 0;
+	};
+
+	struct TeSnapshotComponentHeader {
+		// Registration id in TeECS, so snapshots only load into an ECS with the same registrations
+		uint64_t componentId = 0;
+		uint64_t count = 0;
+		// Size of each raw component, 0 if the blob holds serialized components
+		uint64_t elementSize = 0;
+		uint64_t blobBytes = 0;
+	};
+
+	// Checked view over a snapshot that points into its data. Entities are referred to by their
+	// position in the entity table, which is the order they had in the saved scene
+	class TeSnapshotView {
+	public:
+		struct Section {
+			TeSnapshotComponentHeader header;
+			const char* indices;
+			const char* blob;
+			// From the start of the snapshot
+			size_t blobOffset;
+		};
+
+		// Throws if the snapshot is malformed or saved by another version
+		TeSnapshotView(const char* data, size_t size);
+
+		size_t getEntityCount() const { return static_cast<size_t>(header.entityCount); }
+		std::string_view getName(size_t entity) const { return std::string_view(names + nameOffsets[entity], nameOffsets[entity + 1] - nameOffsets[entity]); }
+		TeEntity getHandle(size_t entity) const;
+		const std::vector<Section>& getSections() const { return sections; }
+
+		static uint32_t getEntity(const Section& section, size_t i);
+	private:
+		TeSnapshotHeader header;
+		const char* handles;
+		const char* names;
+		std::vector<size_t> nameOffsets;
+		std::vector<Section> sections;
+	};
+}
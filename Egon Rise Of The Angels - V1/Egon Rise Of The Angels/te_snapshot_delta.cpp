@@ -0,0 +1,334 @@
+#include "te_ecs.hpp"
+#include "te_snapshot_delta.hpp"
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace te {
+	namespace {
+		constexpr uint32_t NONE = UINT32_MAX;
+
+		struct Span {
+			const char* data = nullptr;
+			size_t size = 0;
+		};
+
+		using SectionPair = std::pair<const TeSnapshotView::Section*, const TeSnapshotView::Section*>;
+
+		// Component of every entity in the table, empty for the ones without it
+		std::vector<Span> getComponents(const TeSnapshotView::Section* section, size_t entityCount) {
+			std::vector<Span> spans(entityCount);
+			if (!section) {
+				return spans;
+			}
+			TeArchiveReader blob{ section->blob, static_cast<size_t>(section->header.blobBytes) };
+			for (size_t i = 0; i < section->header.count; i++) {
+				size_t size = section->header.elementSize ? static_cast<size_t>(section->header.elementSize) : static_cast<size_t>(blob.read<uint64_t>());
+				spans[TeSnapshotView::getEntity(*section, i)] = { blob.read(size), size };
+			}
+			return spans;
+		}
+
+		void writeComponent(TeArchiveWriter& writer, uint64_t elementSize, const Span& span) {
+			if (!elementSize) {
+				writer.write<uint64_t>(span.size);
+			}
+			writer.write(span.data, span.size);
+		}
+
+		// Snapshots list entities in index order, which is what lets them be matched with a merge
+		void checkOrder(const TeSnapshotView& snapshot) {
+			for (size_t i = 1; i < snapshot.getEntityCount(); i++) {
+				if (snapshot.getHandle(i - 1).index >= snapshot.getHandle(i).index) {
+					throw std::runtime_error("snapshot entities are out of order");
+				}
+			}
+		}
+
+		void checkElementSize(const SectionPair& sections, uint64_t elementSize) {
+			if (sections.first && sections.first->header.elementSize != elementSize) {
+				throw std::runtime_error("component layout changed between snapshots");
+			}
+		}
+
+		uint32_t readPosition(TeArchiveReader& reader, size_t count) {
+			uint32_t position = reader.read<uint32_t>();
+			if (position >= count) {
+				throw std::runtime_error("snapshot delta refers to an entity that doesn't exist");
+			}
+			return position;
+		}
+	}
+
+	void TeSnapshotDelta::create(const TeSnapshotView& base, const TeSnapshotView& target, TeArchiveWriter& writer) {
+		checkOrder(base);
+		checkOrder(target);
+		size_t baseCount = base.getEntityCount();
+		size_t targetCount = target.getEntityCount();
+
+		std::vector<uint32_t> targetToBase(targetCount, NONE);
+		std::vector<bool> survived(baseCount);
+		for (size_t t = 0, b = 0; t < targetCount; t++) {
+			TeEntity handle = target.getHandle(t);
+			while (b < baseCount && base.getHandle(b).index < handle.index) b++;
+			if (b < baseCount && base.getHandle(b) == handle) {
+				targetToBase[t] = static_cast<uint32_t>(b);
+				survived[b++] = true;
+			}
+		}
+
+		TeSnapshotDeltaHeader header{};
+		header.baseEntityCount = baseCount;
+		header.targetEntityCount = targetCount;
+		size_t start = writer.reserve<TeSnapshotDeltaHeader>();
+		for (uint32_t b = 0; b < baseCount; b++) {
+			if (survived[b]) continue;
+			writer.write(b);
+			header.destroyedCount++;
+		}
+		for (uint32_t t = 0; t < targetCount; t++) {
+			if (targetToBase[t] != NONE) continue;
+			writer.write(t);
+			writer.write(target.getHandle(t));
+			writer.writeString(target.getName(t));
+			header.createdCount++;
+		}
+		for (uint32_t t = 0; t < targetCount; t++) {
+			if (targetToBase[t] == NONE || target.getName(t) == base.getName(targetToBase[t])) continue;
+			writer.write(t);
+			writer.writeString(target.getName(t));
+			header.renamedCount++;
+		}
+
+		std::map<uint64_t, SectionPair> types;
+		for (const auto& section : base.getSections()) {
+			types[section.header.componentId].first = &section;
+		}
+		for (const auto& section : target.getSections()) {
+			types[section.header.componentId].second = &section;
+		}
+		std::vector<uint32_t> changed;
+		std::vector<uint32_t> removed;
+		for (auto& [componentId, sections] : types) {
+			uint64_t elementSize = sections.second ? sections.second->header.elementSize : sections.first->header.elementSize;
+			checkElementSize(sections, elementSize);
+			std::vector<Span> baseComponents = getComponents(sections.first, baseCount);
+			std::vector<Span> targetComponents = getComponents(sections.second, targetCount);
+
+			changed.clear();
+			removed.clear();
+			for (uint32_t t = 0; t < targetCount; t++) {
+				const Span& current = targetComponents[t];
+				Span previous = targetToBase[t] == NONE ? Span{} : baseComponents[targetToBase[t]];
+				if (current.data) {
+					if (!previous.data || previous.size != current.size || std::memcmp(previous.data, current.data, current.size) != 0) {
+						changed.push_back(t);
+					}
+				}
+				else if (previous.data) {
+					removed.push_back(t);
+				}
+			}
+			if (changed.empty() && removed.empty()) continue;
+
+			TeSnapshotDeltaComponentHeader section{};
+			section.componentId = componentId;
+			section.elementSize = elementSize;
+			section.changedCount = changed.size();
+			section.removedCount = removed.size();
+			size_t sectionOffset = writer.reserve<TeSnapshotDeltaComponentHeader>();
+			writer.write(changed.data(), changed.size() * sizeof(uint32_t));
+			writer.write(removed.data(), removed.size() * sizeof(uint32_t));
+			size_t blobOffset = writer.size();
+			for (uint32_t t : changed) {
+				writeComponent(writer, elementSize, targetComponents[t]);
+			}
+			section.blobBytes = writer.size() - blobOffset;
+			writer.patch(sectionOffset, section);
+			header.componentTypeCount++;
+		}
+		writer.patch(start, header);
+	}
+
+	std::vector<char> TeSnapshotDelta::create(const std::vector<char>& base, const std::vector<char>& target) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		create(TeSnapshotView(base.data(), base.size()), TeSnapshotView(target.data(), target.size()), writer);
+		return output;
+	}
+
+	void TeSnapshotDelta::apply(const TeSnapshotView& base, const char* delta, size_t size, TeArchiveWriter& writer) {
+		TeArchiveReader reader{ delta, size };
+		TeSnapshotDeltaHeader header = reader.read<TeSnapshotDeltaHeader>();
+		if (header.magic != TeSnapshotDeltaHeader::MAGIC || header.version != TeSnapshotDeltaHeader::VERSION) {
+			throw std::runtime_error("not a snapshot delta or saved by an unsupported version");
+		}
+		size_t baseCount = base.getEntityCount();
+		if (header.baseEntityCount != baseCount || header.destroyedCount > baseCount || header.createdCount > size / sizeof(uint32_t)
+			|| header.targetEntityCount != baseCount - header.destroyedCount + header.createdCount) {
+			throw std::runtime_error("snapshot delta was made from a different snapshot");
+		}
+		size_t targetCount = static_cast<size_t>(header.targetEntityCount);
+
+		std::vector<bool> survived(baseCount, true);
+		for (uint64_t i = 0, previous = 0; i < header.destroyedCount; i++) {
+			uint32_t b = readPosition(reader, baseCount);
+			if (i > 0 && b <= previous) {
+				throw std::runtime_error("snapshot delta is corrupt");
+			}
+			survived[b] = false;
+			previous = b;
+		}
+
+		// Created entities take their own positions, survivors fill the rest in order
+		std::vector<uint32_t> targetToBase(targetCount, NONE);
+		std::vector<TeEntity> handles(targetCount);
+		std::vector<std::string_view> names(targetCount);
+		std::vector<bool> created(targetCount);
+		for (uint64_t i = 0; i < header.createdCount; i++) {
+			uint32_t t = readPosition(reader, targetCount);
+			if (created[t]) {
+				throw std::runtime_error("snapshot delta is corrupt");
+			}
+			created[t] = true;
+			handles[t] = reader.read<TeEntity>();
+			names[t] = reader.readString();
+		}
+		for (size_t t = 0, b = 0; t < targetCount; t++) {
+			if (created[t]) continue;
+			while (!survived[b]) b++;
+			targetToBase[t] = static_cast<uint32_t>(b);
+			handles[t] = base.getHandle(b);
+			names[t] = base.getName(b);
+			b++;
+		}
+		for (uint64_t i = 0; i < header.renamedCount; i++) {
+			uint32_t t = readPosition(reader, targetCount);
+			names[t] = reader.readString();
+		}
+
+		// The delta's sections are all read before anything is written
+		struct Changes {
+			TeSnapshotDeltaComponentHeader header;
+			TeArchiveReader changed{ nullptr, 0 };
+			TeArchiveReader removed{ nullptr, 0 };
+			TeArchiveReader blob{ nullptr, 0 };
+		};
+		if (header.componentTypeCount > size / sizeof(TeSnapshotDeltaComponentHeader)) {
+			throw std::runtime_error("snapshot delta is truncated");
+		}
+		std::vector<Changes> changes(static_cast<size_t>(header.componentTypeCount));
+		std::map<uint64_t, std::pair<SectionPair, const Changes*>> types;
+		for (const auto& section : base.getSections()) {
+			types[section.header.componentId].first.first = &section;
+		}
+		for (Changes& change : changes) {
+			change.header = reader.read<TeSnapshotDeltaComponentHeader>();
+			if (change.header.changedCount > size / sizeof(uint32_t) || change.header.removedCount > size / sizeof(uint32_t)) {
+				throw std::runtime_error("snapshot delta is truncated");
+			}
+			change.changed = reader.readArchive(static_cast<size_t>(change.header.changedCount) * sizeof(uint32_t));
+			change.removed = reader.readArchive(static_cast<size_t>(change.header.removedCount) * sizeof(uint32_t));
+			change.blob = reader.readArchive(static_cast<size_t>(change.header.blobBytes));
+			types[change.header.componentId].second = &change;
+		}
+
+		TeSnapshotHeader snapshot{};
+		snapshot.entityCount = targetCount;
+		size_t start = writer.reserve<TeSnapshotHeader>();
+		for (std::string_view name : names) {
+			writer.write(static_cast<uint32_t>(name.size()));
+			snapshot.nameBytes += name.size();
+		}
+		writer.write(handles.data(), handles.size() * sizeof(TeEntity));
+		for (std::string_view name : names) {
+			writer.write(name.data(), name.size());
+		}
+
+		std::vector<Span> components;
+		for (auto& [componentId, type] : types) {
+			auto& [sections, change] = type;
+			uint64_t elementSize = change ? change->header.elementSize : sections.first->header.elementSize;
+			checkElementSize(sections, elementSize);
+
+			std::vector<Span> baseComponents = getComponents(sections.first, baseCount);
+			components.assign(targetCount, Span{});
+			for (size_t t = 0; t < targetCount; t++) {
+				if (targetToBase[t] != NONE) {
+					components[t] = baseComponents[targetToBase[t]];
+				}
+			}
+			if (change) {
+				TeArchiveReader removed = change->removed;
+				while (!removed.isEmpty()) {
+					components[readPosition(removed, targetCount)] = {};
+				}
+				TeArchiveReader changed = change->changed;
+				TeArchiveReader blob = change->blob;
+				while (!changed.isEmpty()) {
+					uint32_t t = readPosition(changed, targetCount);
+					size_t componentSize = elementSize ? static_cast<size_t>(elementSize) : static_cast<size_t>(blob.read<uint64_t>());
+					components[t] = { blob.read(componentSize), componentSize };
+				}
+			}
+
+			TeSnapshotComponentHeader section{};
+			section.componentId = componentId;
+			section.elementSize = elementSize;
+			for (uint32_t t = 0; t < targetCount; t++) {
+				if (components[t].data) section.count++;
+			}
+			if (section.count == 0) continue;
+			size_t sectionOffset = writer.reserve<TeSnapshotComponentHeader>();
+			for (uint32_t t = 0; t < targetCount; t++) {
+				if (components[t].data) writer.write(t);
+			}
+			writer.align(TeSnapshotHeader::BLOB_ALIGNMENT, start);
+			size_t blobOffset = writer.size();
+			for (const Span& component : components) {
+				if (component.data) writeComponent(writer, elementSize, component);
+			}
+			section.blobBytes = writer.size() - blobOffset;
+			writer.patch(sectionOffset, section);
+			snapshot.componentTypeCount++;
+		}
+		writer.patch(start, snapshot);
+	}
+
+	std::vector<char> TeSnapshotDelta::apply(const std::vector<char>& base, const std::vector<char>& delta) {
+		std::vector<char> output;
+		TeArchiveWriter writer{ output };
+		apply(TeSnapshotView(base.data(), base.size()), delta.data(), delta.size(), writer);
+		return output;
+	}
+
+	bool TeSnapshotDelta::isDelta(const char* data, size_t size) {
+		uint32_t magic;
+		if (size < sizeof(TeSnapshotDeltaHeader)) {
+			return false;
+		}
+		std::memcpy(&magic, data, sizeof(magic));
+		return magic == TeSnapshotDeltaHeader::MAGIC;
+	}
+
+	std::vector<char> TeScene::saveSnapshotDelta(std::vector<char>& base, TeWorkerPool* workers) {
+		std::vector<char> current = saveSnapshot(workers);
+		if (base.empty()) {
+			base = current;
+			return current;
+		}
+		std::vector<char> delta = TeSnapshotDelta::create(base, current);
+		base = std::move(current);
+		return delta;
+	}
+
+	std::vector<TeScene::Entity> TeScene::restoreSnapshotDelta(std::vector<char>& base, const std::vector<char>& next) {
+		std::vector<char> target = TeSnapshotDelta::isDelta(next) ? TeSnapshotDelta::apply(base, next) : next;
+		std::vector<Entity> output = restoreSnapshot(target);
+		base = std::move(target);
+		return output;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "te_archive.hpp"
+#include "te_snapshot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace te {
+	// Layout of a delta from TeSnapshotDelta::create, which turns one snapshot of a scene into a
+	// later one of the same scene:
+	//   TeSnapshotDeltaHeader
+	//   a uint32_t base entity table position per destroyed entity, ascending
+	//   per created entity, ascending by position: its uint32_t target entity table position, its
+	//   TeEntity handle and its name as a uint64_t length and the bytes
+	//   per renamed entity: its uint32_t target position and its new name
+	//   per component type with changes: TeSnapshotDeltaComponentHeader, the uint32_t target
+	//   positions of the entities whose component was added or changed, then of the ones that lost
+	//   it, then the added or changed components stored the same way as in a snapshot blob
+	// Entities that were neither created nor destroyed keep their order, so their positions in the
+	// target follow from the rest
+	struct TeSnapshotDeltaHeader {
+		static constexpr uint32_t MAGIC = 0x44534554; // "TESD"
+		static constexpr uint32_t VERSION = 1;
+
+		uint32_t magic = MAGIC;
+		uint32_t version = VERSION;
+		uint64_t baseEntityCount = 0;
+		uint64_t targetEntityCount = 0;
+		uint64_t destroyedCount = 0;
+		uint64_t createdCount = 0;
+		uint64_t renamedCount = 0;
+		uint64_t componentTypeCount = 0;
+	};
+
+	struct TeSnapshotDeltaComponentHeader {
+		uint64_t componentId = 0;
+		// Same meaning as in TeSnapshotComponentHeader
+		uint64_t elementSize = 0;
+		uint64_t changedCount = 0;
+		uint64_t removedCount = 0;
+		uint64_t blobBytes = 0;
+	};
+
+	class TeSnapshotDelta {
+	public:
+		// Entities are matched by handle and components compared as stored, so only what was
+		// created, destroyed, renamed or written with different bytes ends up in the delta.
+		// Both snapshots have to come from the same scene
+		static void create(const TeSnapshotView& base, const TeSnapshotView& target, TeArchiveWriter& writer);
+
+		static std::vector<char> create(const std::vector<char>& base, const std::vector<char>& target);
+
+		// Writes the target snapshot back out. It has the same entities, names and components as
+		// the one the delta was made from, components of a type are in entity order. Throws if the
+		// delta is malformed or was made from a different base
+		static void apply(const TeSnapshotView& base, const char* delta, size_t size, TeArchiveWriter& writer);
+
+		static std::vector<char> apply(const std::vector<char>& base, const std::vector<char>& delta);
+
+		// True if the data starts like a delta rather than a full snapshot, which is how the
+		// results of TeScene::saveSnapshotDelta are told apart
+		static bool isDelta(const char* data, size_t size);
+
+		static bool isDelta(const std::vector<char>& data) { return isDelta(data.data(), data.size()); }
+	};
+}
@@ -0,0 +1,122 @@
+#include "te_transform_kernel.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TE_TRANSFORM_KERNEL_X86
+#include "te_transform_kernel_simd.hpp"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace te {
+#ifdef TE_TRANSFORM_KERNEL_X86
+	namespace {
+		struct Sse2 {
+			using Float = __m128;
+			using Int = __m128i;
+			static constexpr size_t WIDTH = 4;
+
+			static Float load(const float* data) { return _mm_loadu_ps(data); }
+			static Float set(float value) { return _mm_set1_ps(value); }
+			static Int set(int value) { return _mm_set1_epi32(value); }
+			static Float zero() { return _mm_setzero_ps(); }
+			static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+			static Float bitAnd(Float a, Float b) { return _mm_and_ps(a, b); }
+			static Float bitXor(Float a, Float b) { return _mm_xor_ps(a, b); }
+			static Float select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+			static Int add(Int a, Int b) { return _mm_add_epi32(a, b); }
+			static Int sub(Int a, Int b) { return _mm_sub_epi32(a, b); }
+			static Int bitAnd(Int a, Int b) { return _mm_and_si128(a, b); }
+			static Int bitAndNot(Int a, Int b) { return _mm_andnot_si128(a, b); }
+			static Int equal(Int a, Int b) { return _mm_cmpeq_epi32(a, b); }
+			static Int shiftLeft29(Int a) { return _mm_slli_epi32(a, 29); }
+			static Int truncate(Float a) { return _mm_cvttps_epi32(a); }
+			static Float toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+			static Float castInt(Int a) { return _mm_castsi128_ps(a); }
+			static __m128 quarter(Float a, size_t) { return a; }
+		};
+
+		bool hasAvx2() {
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) {
+				return false;
+			}
+			// AVX needs the OS to save the upper halves of the registers too
+			__cpuid(info, 1);
+			bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+			__cpuidex(info, 7, 0);
+			return osSavesAvx && (info[1] & (1 << 5));
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+	}
+
+	size_t TeTransformKernel::computeSse2(const TeTransformBatch& batch) {
+		return teComputeTransforms<Sse2>(batch);
+	}
+#endif
+
+	TeTransformKernel::Isa TeTransformKernel::getBestIsa() {
+#ifdef TE_TRANSFORM_KERNEL_X86
+		static const Isa best = hasAvx2() ? Isa::Avx2 : Isa::Sse2;
+		return best;
+#else
+		return Isa::Scalar;
+#endif
+	}
+
+	void TeTransformKernel::compute(const TeTransformBatch& batch, Isa isa) {
+		if (static_cast<int>(isa) > static_cast<int>(getBestIsa())) {
+			throw std::runtime_error("transform kernel instruction set isn't supported by this CPU");
+		}
+		size_t done = 0;
+#ifdef TE_TRANSFORM_KERNEL_X86
+		if (isa == Isa::Avx2) {
+			done = computeAvx2(batch);
+		}
+		else if (isa == Isa::Sse2) {
+			done = computeSse2(batch);
+		}
+#endif
+		computeScalar(batch, done);
+	}
+
+	void TeTransformKernel::computeScalar(const TeTransformBatch& batch, size_t first) {
+		for (size_t i = first; i < batch.count; i++) {
+			const float c3 = std::cos(batch.rotation[2][i]);
+			const float s3 = std::sin(batch.rotation[2][i]);
+			const float c2 = std::cos(batch.rotation[0][i]);
+			const float s2 = std::sin(batch.rotation[0][i]);
+			const float c1 = std::cos(batch.rotation[1][i]);
+			const float s1 = std::sin(batch.rotation[1][i]);
+			const float axes[9] = {
+				c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1,
+				c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3,
+				c2 * s1, -s2, c1 * c2
+			};
+
+			float* model = batch.model + i * 16;
+			float* normal = batch.normal + i * 9;
+			for (int column = 0; column < 3; column++) {
+				const float scale = batch.scale[column][i];
+				for (int row = 0; row < 3; row++) {
+					model[column * 4 + row] = scale * axes[column * 3 + row];
+					normal[column * 3 + row] = axes[column * 3 + row] / scale;
+				}
+				model[column * 4 + 3] = 0.0f;
+				model[12 + column] = batch.translation[column][i];
+			}
+			model[15] = 1.0f;
+		}
+	}
+}
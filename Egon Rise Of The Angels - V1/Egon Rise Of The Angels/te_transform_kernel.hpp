@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+
+namespace te {
+	// Structure of arrays input for TeTransformKernel, count entries in every array. Rotations are
+	// Tait-Bryan angles applied in Y, X, Z order, like TransformComponent
+	struct TeTransformBatch {
+		size_t count = 0;
+		const float* translation[3]{};
+		const float* rotation[3]{};
+		const float* scale[3]{};
+
+		// Column major like glm, 16 floats per model matrix and 9 per normal matrix
+		float* model = nullptr;
+		float* normal = nullptr;
+	};
+
+	// Computes TransformComponent's model and normal matrices for many transforms at once, 8 at a
+	// time with AVX2 or 4 with SSE2, whichever the CPU has. The SIMD paths use a polynomial sine
+	// and cosine accurate to a few float ulps for angles up to a few thousand radians
+	class TeTransformKernel {
+	public:
+		enum class Isa {
+			Scalar,
+			Sse2,
+			Avx2
+		};
+
+		// The best the CPU and OS support, checked once
+		static Isa getBestIsa();
+
+		static void compute(const TeTransformBatch& batch) { compute(batch, getBestIsa()); }
+
+		// Throws if the CPU doesn't support isa
+		static void compute(const TeTransformBatch& batch, Isa isa);
+	private:
+		// Entries from first on, one at a time with the standard library's sin and cos
+		static void computeScalar(const TeTransformBatch& batch, size_t first);
+
+		// Each returns how many entries it did, a multiple of its width
+		static size_t computeSse2(const TeTransformBatch& batch);
+
+		static size_t computeAvx2(const TeTransformBatch& batch);
+	};
+}
@@ -0,0 +1,44 @@
+// Built with AVX2 enabled (-mavx2 on GCC and Clang, MSVC needs no flag), only ever called once
+// TeTransformKernel has checked the CPU supports it
+
+#include "te_transform_kernel.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include "te_transform_kernel_simd.hpp"
+
+namespace te {
+	namespace {
+		struct Avx2 {
+			using Float = __m256;
+			using Int = __m256i;
+			static constexpr size_t WIDTH = 8;
+
+			static Float load(const float* data) { return _mm256_loadu_ps(data); }
+			static Float set(float value) { return _mm256_set1_ps(value); }
+			static Int set(int value) { return _mm256_set1_epi32(value); }
+			static Float zero() { return _mm256_setzero_ps(); }
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+			static Float bitAnd(Float a, Float b) { return _mm256_and_ps(a, b); }
+			static Float bitXor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+			static Float select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+			static Int add(Int a, Int b) { return _mm256_add_epi32(a, b); }
+			static Int sub(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+			static Int bitAnd(Int a, Int b) { return _mm256_and_si256(a, b); }
+			static Int bitAndNot(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+			static Int equal(Int a, Int b) { return _mm256_cmpeq_epi32(a, b); }
+			static Int shiftLeft29(Int a) { return _mm256_slli_epi32(a, 29); }
+			static Int truncate(Float a) { return _mm256_cvttps_epi32(a); }
+			static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+			static Float castInt(Int a) { return _mm256_castsi256_ps(a); }
+			static __m128 quarter(Float a, size_t i) { return i == 0 ? _mm256_castps256_ps128(a) : _mm256_extractf128_ps(a, 1); }
+		};
+	}
+
+	size_t TeTransformKernel::computeAvx2(const TeTransformBatch& batch) {
+		return teComputeTransforms<Avx2>(batch);
+	}
+}
+#endif
@@ -0,0 +1,123 @@
+#pragma once
+
+// Width independent parts of the SIMD transform kernels, only for te_transform_kernel*.cpp. Every
+// function here is static, so the AVX2 file's copies, compiled for AVX2, never stand in for the
+// SSE2 file's ones
+
+#include "te_transform_kernel.hpp"
+
+#include <immintrin.h>
+
+namespace te {
+	// Writes 4 transforms' matrices from structure of arrays registers, m holding model matrix
+	// elements and n normal matrix elements, column major
+	static inline void teStoreTransforms4(const __m128* m, const __m128* n, float* model, float* normal) {
+		for (int column = 0; column < 4; column++) {
+			__m128 r0 = m[column * 4], r1 = m[column * 4 + 1], r2 = m[column * 4 + 2], r3 = m[column * 4 + 3];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(model + column * 4, r0);
+			_mm_storeu_ps(model + 16 + column * 4, r1);
+			_mm_storeu_ps(model + 32 + column * 4, r2);
+			_mm_storeu_ps(model + 48 + column * 4, r3);
+		}
+		for (int part = 0; part < 2; part++) {
+			__m128 r0 = n[part * 4], r1 = n[part * 4 + 1], r2 = n[part * 4 + 2], r3 = n[part * 4 + 3];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(normal + part * 4, r0);
+			_mm_storeu_ps(normal + 9 + part * 4, r1);
+			_mm_storeu_ps(normal + 18 + part * 4, r2);
+			_mm_storeu_ps(normal + 27 + part * 4, r3);
+		}
+		alignas(16) float last[4];
+		_mm_store_ps(last, n[8]);
+		for (int i = 0; i < 4; i++) {
+			normal[i * 9 + 8] = last[i];
+		}
+	}
+
+	// Sine and cosine together, after Cephes' sinf and cosf: the angle is reduced to [-pi/4, pi/4]
+	// in three steps to keep precision, then one of two polynomials gives each result
+	template<typename V>
+	static inline void teSinCos(typename V::Float x, typename V::Float& sine, typename V::Float& cosine) {
+		using Float = typename V::Float;
+		using Int = typename V::Int;
+		const Float signMask = V::castInt(V::set(static_cast<int>(0x80000000)));
+		Float sineSign = V::bitAnd(x, signMask);
+		x = V::bitXor(x, sineSign);
+
+		// Octant, rounded up to even so the remainder is centred on zero
+		Int octant = V::truncate(V::mul(x, V::set(1.27323954473516f)));
+		octant = V::bitAnd(V::add(octant, V::set(1)), V::set(~1));
+		Float y = V::toFloat(octant);
+
+		Float swapSineSign = V::castInt(V::shiftLeft29(V::bitAnd(octant, V::set(4))));
+		Float useSinePolynomial = V::castInt(V::equal(V::bitAnd(octant, V::set(2)), V::set(0)));
+		Float cosineSign = V::castInt(V::shiftLeft29(V::bitAndNot(V::sub(octant, V::set(2)), V::set(4))));
+		sineSign = V::bitXor(sineSign, swapSineSign);
+
+		x = V::sub(x, V::mul(y, V::set(0.78515625f)));
+		x = V::sub(x, V::mul(y, V::set(2.4187564849853515625e-4f)));
+		x = V::sub(x, V::mul(y, V::set(3.77489497744594108e-8f)));
+
+		Float z = V::mul(x, x);
+		Float cosinePart = V::mul(z, V::set(2.443315711809948e-5f));
+		cosinePart = V::mul(V::add(cosinePart, V::set(-1.388731625493765e-3f)), z);
+		cosinePart = V::mul(V::add(cosinePart, V::set(4.166664568298827e-2f)), z);
+		cosinePart = V::mul(cosinePart, z);
+		cosinePart = V::add(V::sub(cosinePart, V::mul(z, V::set(0.5f))), V::set(1.0f));
+
+		Float sinePart = V::mul(z, V::set(-1.9515295891e-4f));
+		sinePart = V::mul(V::add(sinePart, V::set(8.3321608736e-3f)), z);
+		sinePart = V::mul(V::add(sinePart, V::set(-1.6666654611e-1f)), z);
+		sinePart = V::add(V::mul(sinePart, x), x);
+
+		sine = V::bitXor(V::select(useSinePolynomial, sinePart, cosinePart), sineSign);
+		cosine = V::bitXor(V::select(useSinePolynomial, cosinePart, sinePart), cosineSign);
+	}
+
+	// Every whole group of V::WIDTH entries, returns how many that was
+	template<typename V>
+	static inline size_t teComputeTransforms(const TeTransformBatch& batch) {
+		using Float = typename V::Float;
+		size_t end = batch.count - batch.count % V::WIDTH;
+		for (size_t i = 0; i < end; i += V::WIDTH) {
+			Float s1, c1, s2, c2, s3, c3;
+			teSinCos<V>(V::load(batch.rotation[1] + i), s1, c1);
+			teSinCos<V>(V::load(batch.rotation[0] + i), s2, c2);
+			teSinCos<V>(V::load(batch.rotation[2] + i), s3, c3);
+
+			// Rotation columns, the same products as TransformComponent::mat4
+			Float s2s3 = V::mul(s2, s3);
+			Float c3s2 = V::mul(c3, s2);
+			Float axes[9] = {
+				V::add(V::mul(c1, c3), V::mul(s1, s2s3)), V::mul(c2, s3), V::sub(V::mul(c1, s2s3), V::mul(c3, s1)),
+				V::sub(V::mul(s1, c3s2), V::mul(c1, s3)), V::mul(c2, c3), V::add(V::mul(c1, c3s2), V::mul(s1, s3)),
+				V::mul(c2, s1), V::sub(V::zero(), s2), V::mul(c1, c2)
+			};
+
+			Float m[16];
+			Float n[9];
+			for (int column = 0; column < 3; column++) {
+				Float scale = V::load(batch.scale[column] + i);
+				Float inverseScale = V::div(V::set(1.0f), scale);
+				for (int row = 0; row < 3; row++) {
+					m[column * 4 + row] = V::mul(axes[column * 3 + row], scale);
+					n[column * 3 + row] = V::mul(axes[column * 3 + row], inverseScale);
+				}
+				m[column * 4 + 3] = V::zero();
+				m[12 + column] = V::load(batch.translation[column] + i);
+			}
+			m[15] = V::set(1.0f);
+
+			for (size_t quarter = 0; quarter < V::WIDTH / 4; quarter++) {
+				__m128 m4[16];
+				__m128 n4[9];
+				for (int j = 0; j < 16; j++) m4[j] = V::quarter(m[j], quarter);
+				for (int j = 0; j < 9; j++) n4[j] = V::quarter(n[j], quarter);
+				size_t entry = i + quarter * 4;
+				teStoreTransforms4(m4, n4, batch.model + entry * 16, batch.normal + entry * 9);
+			}
+		}
+		return end;
+	}
+}
@@ -0,0 +1,74 @@
+#include "transform_system.hpp"
+#include "te_transform_kernel.hpp"
+
+#include <cstring>
+
+namespace te {
+	void TransformSystem::update(TeScene& scene) {
+		// Writes from here on are stamped with the new version or a later one, so the next update sees them
+		uint32_t sinceVersion = lastVersion;
+		lastVersion = scene.advanceChangeVersion();
+		entities.clear();
+		for (std::vector<float>& input : inputs) {
+			input.clear();
+		}
+		scene.view<const TransformComponent>().eachChanged(sinceVersion, [this](TeScene::Entity entity, const TransformComponent& transform) {
+			entities.push_back(entity);
+			for (int k = 0; k < 3; k++) {
+				inputs[k].push_back(transform.translation[k]);
+				inputs[3 + k].push_back(transform.rotation[k]);
+				inputs[6 + k].push_back(transform.scale[k]);
+			}
+		});
+
+		size_t count = entities.size();
+		if (count > 0) {
+			matrices.resize(count * 25);
+			TeTransformBatch batch;
+			batch.count = count;
+			for (int k = 0; k < 3; k++) {
+				batch.translation[k] = inputs[k].data();
+				batch.rotation[k] = inputs[3 + k].data();
+				batch.scale[k] = inputs[6 + k].data();
+			}
+			batch.model = matrices.data();
+			batch.normal = matrices.data() + count * 16;
+			TeTransformKernel::compute(batch);
+
+			for (size_t i = 0; i < count; i++) {
+				if (entities[i].index >= entityMatrices.size()) {
+					entityMatrices.resize(static_cast<size_t>(entities[i].index) + 1);
+				}
+				Matrices& output = entityMatrices[entities[i].index];
+				std::memcpy(&output.model[0][0], batch.model + i * 16, 16 * sizeof(float));
+				std::memcpy(&output.normal[0][0], batch.normal + i * 9, 9 * sizeof(float));
+				if (output.generation == UINT32_MAX) {
+					entityMatrixCount++;
+				}
+				output.generation = entities[i].generation;
+			}
+		}
+
+		if (entityMatrixCount != scene.countComponents<TransformComponent>()) {
+			dropStale(scene);
+		}
+	}
+
+	void TransformSystem::dropStale(TeScene& scene) {
+		for (uint32_t index = 0; index < entityMatrices.size(); index++) {
+			Matrices& entry = entityMatrices[index];
+			if (entry.generation != UINT32_MAX && !scene.getComponent<const TransformComponent>({ index, entry.generation })) {
+				entry = Matrices{};
+				entityMatrixCount--;
+			}
+		}
+	}
+
+	const TransformSystem::Matrices& TransformSystem::getMatrices(TeScene::Entity entity) const {
+		static const Matrices identity{};
+		if (entity.index < entityMatrices.size() && entityMatrices[entity.index].generation == entity.generation) {
+			return entityMatrices[entity.index];
+		}
+		return identity;
+	}
+}
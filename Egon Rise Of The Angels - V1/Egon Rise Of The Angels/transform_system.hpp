@@ -0,0 +1,51 @@
+#pragma once
+
+#include "te_game_object.hpp"
+
+#include <array>
+#include <vector>
+
+namespace te {
+	// Keeps the model and normal matrices of every TransformComponent in a scene. A transform's
+	// change version is its dirty flag: only the ones added or written through non-const access
+	// since the last update are recomputed, so transforms that never move cost no matrix math.
+	// The ones that did are recomputed together by TeTransformKernel
+	class TransformSystem {
+	public:
+		// Run after the systems that move things and before the ones that read the matrices. Only
+		// reads transforms, schedule it as writing TransformSystem and its readers as reading it
+		void update(TeScene& scene);
+
+		// TransformComponent::mat4() and normalMatrix(), to within float rounding, as of the last
+		// update. Identity for an entity that had no transform then
+		const glm::mat4& getModelMatrix(TeScene::Entity entity) const { return getMatrices(entity).model; }
+		const glm::mat3& getNormalMatrix(TeScene::Entity entity) const { return getMatrices(entity).normal; }
+	private:
+		// Derived state, kept out of the scene so snapshots and captures never see it
+		struct Matrices {
+			glm::mat4 model{ 1.0f };
+			glm::mat3 normal{ 1.0f };
+			uint32_t generation = UINT32_MAX;
+		};
+
+		const Matrices& getMatrices(TeScene::Entity entity) const;
+
+		// Drops the matrices of entities that lost their transform or were destroyed
+		void dropStale(TeScene& scene);
+
+		uint32_t lastVersion = 0;
+
+		// Indexed by Entity::index
+		std::vector<Matrices> entityMatrices;
+
+		// Entries of entityMatrices holding an entity's matrices. Removals leave no change stamp,
+		// so more of them than the scene has transforms means some are stale
+		size_t entityMatrixCount = 0;
+
+		// Kept between updates so a frame doesn't allocate. Translation, rotation and scale, one
+		// array per component
+		std::vector<TeScene::Entity> entities;
+		std::array<std::vector<float>, 9> inputs;
+		std::vector<float> matrices;
+	};
+}
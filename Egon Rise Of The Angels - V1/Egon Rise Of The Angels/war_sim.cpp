@@ -4,6 +4,8 @@
 #include <memory>
 #include <array>
 #include <chrono>
+#include <future>
+#include <iostream>
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -16,9 +18,11 @@
 #include "te_buffer.hpp"
 #include "te_frame_info.hpp"
 #include "simple_render_system.hpp"
+#include "transform_system.hpp"
 #include "te_game_object.hpp"
 #include "te_texture.hpp"
 #include "te_physics.hpp"
+#include "te_scene_capture.hpp"
 
 namespace te {
     using id_t = unsigned int;
@@ -84,6 +88,7 @@ namespace te {
             globalSetLayout,
             globalPool
         };
+        TransformSystem transformSystem{};
 
         registerComponents();
 
@@ -91,6 +96,41 @@ namespace te {
 
         registerCommmands();
 
+        // Systems run concurrently where their declared access allows, in registration order otherwise
+        FrameInfo* currentFrame = nullptr;
+        TeSystemScheduler scheduler{ workerPool };
+        TeName viewerName = scene->internName("camera_1");
+        scheduler.addSystem("ubo", [&] {
+            GlobalUbo ubo{};
+            ubo.projection = camera.getProjection();
+            ubo.view = camera.getView();
+            uboBuffers[currentFrame->frameIndex]->writeToBuffer(&ubo);
+            uboBuffers[currentFrame->frameIndex]->flush();
+        }).reads<TeCamera>();
+        scheduler.addSystem("logger", [&] {
+            logger.run();
+        }).reads<TransformComponent, ModelComponent>().writes<TeLogger>();
+        scheduler.addSystem("camera", [&] {
+            TeScene::Entity viewerObject = scene->getEntityByName(viewerName);
+            cameraController.moveInPlaneXZ(*currentFrame, viewerObject, logger.hasMovedSinceLastLog);
+            const TransformComponent* viewerObjectTransform = scene->getComponent<const TransformComponent>(viewerObject);
+            camera.setViewYXZ(viewerObjectTransform->translation, viewerObjectTransform->rotation);
+        }).writes<TransformComponent, TeCamera, TeLogger>().onMainThread();
+        // Registered between what moves transforms and what draws them, so the matrices are never a frame behind.
+        // It only reads transforms, the matrices it writes are ordered against render through the TransformSystem key
+        scheduler.addSystem("transforms", [&] {
+            transformSystem.update(*scene);
+        }).reads<TransformComponent>().writes<TransformSystem>();
+        scheduler.addSystem("render", [&] {
+            teRenderer.beginSwapChainRenderPass(currentFrame->commandBuffer);
+            simpleRenderSystem.renderGameObjects(*currentFrame, transformSystem);
+            teRenderer.endSwapChainRenderPass(currentFrame->commandBuffer);
+        }).reads<TransformComponent, ModelComponent, TeCamera, TransformSystem>();
+
+        // Written on its own thread from a capture, so saving never holds up a frame
+        std::future<void> autosave;
+        auto lastAutosave = currentTime;
+
         while (!glfwWindowShouldClose(teWindow.getGLFWwindow())) {
             auto commandBuffer = teRenderer.beginFrame();
 
@@ -118,24 +158,31 @@ namespace te {
             }
 
             if (commandBuffer) {
-                // update
-                GlobalUbo ubo{};
-                ubo.projection = camera.getProjection();
-                ubo.view = camera.getView();
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
-                logger.run();
-                cameraController.moveInPlaneXZ(frameInfo, scene->getEntityByName("camera_1"), logger.hasMovedSinceLastLog);
-                TransformComponent* viewerObjectTransform = scene->getComponent<TransformComponent>(scene->getEntityByName("camera_1"));
-                camera.setViewYXZ(viewerObjectTransform->translation, viewerObjectTransform->rotation);
-
-                // render
-                teRenderer.beginSwapChainRenderPass(commandBuffer);
-                simpleRenderSystem.renderGameObjects(frameInfo);
-                teRenderer.endSwapChainRenderPass(commandBuffer);
+                // update and render run inside one read phase, structural changes from other threads wait for the sync point
+                currentFrame = &frameInfo;
+                scheduler.run(*scene);
                 teRenderer.endFrame();
             }
 
+            // sync point
+            entityCommands.playback(*scene);
+            loader.apply(*scene);
+
+            if (newTime - lastAutosave > AUTOSAVE_INTERVAL && (!autosave.valid() || autosave.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+                if (autosave.valid()) {
+                    try {
+                        autosave.get();
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << "autosave failed: " << e.what() << std::endl;
+                    }
+                }
+                lastAutosave = newTime;
+                autosave = std::async(std::launch::async, [capture = scene->capture()] {
+                    capture->saveSnapshotToFile("autosave.snap", nullptr, true);
+                });
+            }
+
             vkDeviceWaitIdle(teDevice.device());
         }
         printf("press enter to exit\n");
@@ -173,5 +220,9 @@ namespace te {
         // log command
         std::function<const char* (std::vector<std::string>, TheEngine&)> logFunction = &TeCommandThread::command_log;
         commandThread.registerCommand(logFunction, "log");
+
+        // load command
+        std::function<const char* (std::vector<std::string>, TheEngine&)> loadFunction = &TeCommandThread::command_load;
+        commandThread.registerCommand(loadFunction, "load");
     }
 }
\ No newline at end of file
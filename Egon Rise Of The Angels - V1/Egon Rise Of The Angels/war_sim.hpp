@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <memory>
 #include <vector>
@@ -9,6 +10,9 @@
 #include "re_window.hpp"
 #include "te_device.hpp"
 #include "te_game_object.hpp"
+#include "te_entity_command_buffer.hpp"
+#include "te_async_loader.hpp"
+#include "te_scheduler.hpp"
 #include "te_renderer.hpp"
 #include "te_descriptors.hpp"
 #include "te_command.hpp"
@@ -26,6 +30,7 @@ namespace te {
 
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr std::chrono::seconds AUTOSAVE_INTERVAL{ 60 };
 
 		void loadGameObjects();
 		void registerComponents();
@@ -38,6 +43,11 @@ namespace te {
 		std::unique_ptr<TeDescriptorPool> globalPool{};
 		TeECS manager{};
 		TeScene* scene;
+		// Structural changes from outside the frame loop, played back between frames
+		TeEntityCommandBuffer entityCommands{};
 		TeLogger logger{ *this };
+		TeWorkerPool workerPool{};
+		// Entity files and models loaded on the loader's own threads, applied at the sync point
+		TeAsyncLoader loader{ manager };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,444 @@
+// Headless ECS microbenchmarks. Every case runs against a fresh TeECS for each entity count and
+// storage policy, setup is excluded from the timings and the best of --repeat runs is reported.
+// Results go to stdout as CSV (default) or one JSON object per line, progress goes to stderr
+#include "te_ecs.hpp"
+#include "te_scene_capture.hpp"
+#include "te_scheduler.hpp"
+#include "te_transform_kernel.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace te {
+	namespace {
+		struct BenchPosition {
+			float x = 0.f, y = 0.f, z = 0.f;
+
+			static constexpr auto fields() { return teFields("BenchPosition", TE_FIELD(BenchPosition, x), TE_FIELD(BenchPosition, y), TE_FIELD(BenchPosition, z)); }
+		};
+
+		struct BenchVelocity {
+			float x = 1.f, y = 2.f, z = 3.f;
+
+			static constexpr auto fields() { return teFields("BenchVelocity", TE_FIELD(BenchVelocity, x), TE_FIELD(BenchVelocity, y), TE_FIELD(BenchVelocity, z)); }
+		};
+
+		struct BenchHealth {
+			int32_t value = 100;
+
+			static constexpr auto fields() { return teFields("BenchHealth", TE_FIELD(BenchHealth, value)); }
+		};
+
+		using Entity = TeScene::Entity;
+		using Clock = std::chrono::steady_clock;
+
+		// Keeps the optimizer from dropping work whose result is otherwise unused
+		volatile size_t sink = 0;
+
+		struct Fixture {
+			Fixture(TeStoragePolicy storage) {
+				ecs.registerComponent<BenchPosition>(storage);
+				ecs.registerComponent<BenchVelocity>(storage);
+				ecs.registerComponent<BenchHealth>(storage);
+				scene = ecs.getScene(ecs.createScene());
+				scene->setLogging(false);
+			}
+
+			std::vector<Entity> populate(size_t count, bool velocity, bool health) {
+				std::vector<Entity> entities = scene->createEntities(count);
+				for (Entity entity : entities) {
+					scene->addComponent(entity, BenchPosition{});
+					if (velocity) scene->addComponent(entity, BenchVelocity{});
+					if (health) scene->addComponent(entity, BenchHealth{});
+				}
+				return entities;
+			}
+
+			TeECS ecs;
+			TeScene* scene;
+		};
+
+		template<typename F>
+		double time(F&& func) {
+			Clock::time_point start = Clock::now();
+			func();
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		}
+
+		// Each case sets up its own fixture and returns the seconds spent in the measured part only
+		using BenchmarkFunc = double (*)(TeStoragePolicy storage, size_t count);
+
+		double benchCreate(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			return time([&] {
+				for (size_t i = 0; i < count; i++) {
+					fixture.scene->createEntity();
+				}
+			});
+		}
+
+		double benchCreateBulk(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			return time([&] { sink = sink + fixture.scene->createEntities(count).size(); });
+		}
+
+		double benchDestroy(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.populate(count, true, false);
+			return time([&] {
+				for (Entity& entity : entities) {
+					fixture.scene->destroyEntity(entity);
+				}
+			});
+		}
+
+		double benchDestroyBulk(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.populate(count, true, false);
+			return time([&] { fixture.scene->destroyEntities(entities); });
+		}
+
+		double benchAddComponent(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.scene->createEntities(count);
+			return time([&] {
+				for (Entity entity : entities) {
+					fixture.scene->addComponent(entity, BenchPosition{});
+				}
+			});
+		}
+
+		double benchRemoveComponent(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.populate(count, true, false);
+			return time([&] {
+				for (Entity entity : entities) {
+					fixture.scene->removeComponent<BenchVelocity>(entity);
+				}
+			});
+		}
+
+		double benchIterateSingle(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			return time([&] {
+				fixture.scene->view<BenchPosition>().each([](Entity, BenchPosition& position) {
+					position.x += 1.f;
+				});
+			});
+		}
+
+		double benchIterateMulti(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			return time([&] {
+				fixture.scene->view<BenchPosition, const BenchVelocity, const BenchHealth>().each([](Entity, BenchPosition& position, const BenchVelocity& velocity, const BenchHealth& health) {
+					if (health.value > 0) {
+						position.x += velocity.x;
+						position.y += velocity.y;
+						position.z += velocity.z;
+					}
+				});
+			});
+		}
+
+		// Only the names are benchmarked, so the entities carry no components
+		std::vector<std::string> createNamed(Fixture& fixture, size_t count) {
+			std::vector<std::string> names;
+			names.reserve(count);
+			for (size_t i = 0; i < count; i++) {
+				names.push_back("entity_" + std::to_string(i));
+				fixture.scene->createEntity(names.back());
+			}
+			return names;
+		}
+
+		double benchNameLookup(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<std::string> names = createNamed(fixture, count);
+			return time([&] {
+				for (const std::string& name : names) {
+					sink = sink + fixture.scene->getEntityByName(name).index;
+				}
+			});
+		}
+
+		double benchNameLookupCached(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<TeName> names;
+			names.reserve(count);
+			for (const std::string& name : createNamed(fixture, count)) {
+				names.push_back(fixture.scene->internName(name));
+			}
+			return time([&] {
+				for (TeName name : names) {
+					sink = sink + fixture.scene->getEntityByName(name).index;
+				}
+			});
+		}
+
+		double benchSerialize(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.populate(count, true, true);
+			return time([&] {
+				for (Entity entity : entities) {
+					sink = sink + fixture.scene->serializeEntity(entity).size();
+				}
+			});
+		}
+
+		// Every entity into one reused arena, warmed up by a first pass so the timed pass doesn't allocate
+		double benchSerializeArena(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.populate(count, true, true);
+			std::vector<char> arena;
+			TeArchiveWriter writer{ arena };
+			for (Entity entity : entities) {
+				fixture.scene->serializeEntity(entity, writer);
+			}
+			arena.clear();
+			return time([&] {
+				for (Entity entity : entities) {
+					fixture.scene->serializeEntity(entity, writer);
+				}
+				sink = sink + arena.size();
+			});
+		}
+
+		double benchDeserialize(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<std::vector<char>> serialized;
+			serialized.reserve(count);
+			for (Entity entity : fixture.populate(count, true, true)) {
+				serialized.push_back(fixture.scene->serializeEntity(entity));
+			}
+			TeScene* target = fixture.ecs.getScene(fixture.ecs.createScene());
+			target->setLogging(false);
+			return time([&] {
+				for (std::vector<char>& data : serialized) {
+					target->deserializeEntity(std::move(data));
+				}
+			});
+		}
+
+		double benchSnapshotSave(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			return time([&] { sink = sink + fixture.scene->saveSnapshot().size(); });
+		}
+
+		double benchSnapshotSaveParallel(TeStoragePolicy storage, size_t count) {
+			static TeWorkerPool workers;
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			return time([&] { sink = sink + fixture.scene->saveSnapshot(&workers).size(); });
+		}
+
+		// Only taking the capture, the time a frame would stall for an autosave
+		double benchSnapshotCapture(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			return time([&] { sink = sink + fixture.scene->capture().use_count(); });
+		}
+
+		// Model and normal matrices for count transforms in one batch. Storage doesn't matter, the
+		// kernel works on plain arrays. Falls back to the best instruction set the CPU has
+		double benchTransforms(size_t count, TeTransformKernel::Isa isa) {
+			if (isa > TeTransformKernel::getBestIsa()) {
+				isa = TeTransformKernel::getBestIsa();
+			}
+			std::vector<float> inputs(count * 9);
+			for (size_t i = 0; i < inputs.size(); i++) {
+				inputs[i] = 0.5f + static_cast<float>(i % 1000) * 0.01f;
+			}
+			std::vector<float> matrices(count * 25);
+			TeTransformBatch batch;
+			batch.count = count;
+			for (int k = 0; k < 3; k++) {
+				batch.translation[k] = inputs.data() + k * count;
+				batch.rotation[k] = inputs.data() + (3 + k) * count;
+				batch.scale[k] = inputs.data() + (6 + k) * count;
+			}
+			batch.model = matrices.data();
+			batch.normal = matrices.data() + count * 16;
+			return time([&] {
+				TeTransformKernel::compute(batch, isa);
+				sink = sink + static_cast<size_t>(matrices[0]);
+			});
+		}
+
+		double benchTransformsScalar(TeStoragePolicy, size_t count) { return benchTransforms(count, TeTransformKernel::Isa::Scalar); }
+
+		double benchTransformsSse2(TeStoragePolicy, size_t count) { return benchTransforms(count, TeTransformKernel::Isa::Sse2); }
+
+		double benchTransformsAvx2(TeStoragePolicy, size_t count) { return benchTransforms(count, TeTransformKernel::Isa::Avx2); }
+
+		// One entity in a hundred moved since the base snapshot
+		double benchSnapshotDelta(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			std::vector<Entity> entities = fixture.populate(count, true, true);
+			std::vector<char> base = fixture.scene->saveSnapshot();
+			for (size_t i = 0; i < entities.size(); i += 100) {
+				fixture.scene->getComponent<BenchPosition>(entities[i])->x += 1.f;
+			}
+			return time([&] { sink = sink + fixture.scene->saveSnapshotDelta(base).size(); });
+		}
+
+		double benchSnapshotLoad(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			std::vector<char> snapshot = fixture.scene->saveSnapshot();
+			TeScene* target = fixture.ecs.getScene(fixture.ecs.createScene());
+			target->setLogging(false);
+			return time([&] { sink = sink + target->loadSnapshot(snapshot).size(); });
+		}
+
+		// Maps the file, the file was just written so this measures a warm page cache
+		double benchSnapshotLoadFile(TeStoragePolicy storage, size_t count) {
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			std::string path = (std::filesystem::temp_directory_path() / "te_ecs_benchmark.snapshot").string();
+			fixture.scene->saveSnapshotToFile(path);
+			TeScene* target = fixture.ecs.getScene(fixture.ecs.createScene());
+			target->setLogging(false);
+			double seconds = time([&] { sink = sink + target->loadSnapshotFromFile(path).size(); });
+			std::filesystem::remove(path);
+			return seconds;
+		}
+
+		double benchSnapshotLoadCompressed(TeStoragePolicy storage, size_t count) {
+			static TeWorkerPool workers;
+			Fixture fixture{ storage };
+			fixture.populate(count, true, true);
+			std::string path = (std::filesystem::temp_directory_path() / "te_ecs_benchmark.snapshot").string();
+			fixture.scene->saveSnapshotToFile(path, &workers, true);
+			TeScene* target = fixture.ecs.getScene(fixture.ecs.createScene());
+			target->setLogging(false);
+			double seconds = time([&] { sink = sink + target->loadSnapshotFromFile(path, &workers).size(); });
+			std::filesystem::remove(path);
+			return seconds;
+		}
+
+		struct Benchmark {
+			const char* name;
+			BenchmarkFunc func;
+		};
+
+		const Benchmark BENCHMARKS[] = {
+			{ "create", &benchCreate },
+			{ "create_bulk", &benchCreateBulk },
+			{ "destroy", &benchDestroy },
+			{ "destroy_bulk", &benchDestroyBulk },
+			{ "add_component", &benchAddComponent },
+			{ "remove_component", &benchRemoveComponent },
+			{ "iterate_single", &benchIterateSingle },
+			{ "iterate_multi", &benchIterateMulti },
+			{ "name_lookup", &benchNameLookup },
+			{ "name_lookup_cached", &benchNameLookupCached },
+			{ "serialize", &benchSerialize },
+			{ "serialize_arena", &benchSerializeArena },
+			{ "deserialize", &benchDeserialize },
+			{ "snapshot_save", &benchSnapshotSave },
+			{ "snapshot_save_parallel", &benchSnapshotSaveParallel },
+			{ "snapshot_capture", &benchSnapshotCapture },
+			{ "snapshot_delta", &benchSnapshotDelta },
+			{ "snapshot_load", &benchSnapshotLoad },
+			{ "snapshot_load_file", &benchSnapshotLoadFile },
+			{ "snapshot_load_compressed", &benchSnapshotLoadCompressed },
+			{ "transforms_scalar", &benchTransformsScalar },
+			{ "transforms_sse2", &benchTransformsSse2 },
+			{ "transforms_avx2", &benchTransformsAvx2 },
+		};
+
+		struct Options {
+			std::vector<size_t> sizes{ 1000, 10000, 100000, 1000000 };
+			std::vector<TeStoragePolicy> storages{ TeStoragePolicy::Archetype, TeStoragePolicy::SparseSet };
+			size_t repeat = 3;
+			bool json = false;
+			std::string filter;
+		};
+
+		const char* storageName(TeStoragePolicy storage) {
+			return storage == TeStoragePolicy::Archetype ? "archetype" : "sparse_set";
+		}
+
+		std::vector<size_t> parseSizes(const std::string& list) {
+			std::vector<size_t> sizes;
+			size_t start = 0;
+			while (start <= list.size()) {
+				size_t end = list.find(',', start);
+				if (end == std::string::npos) end = list.size();
+				sizes.push_back(std::stoull(list.substr(start, end - start)));
+				start = end + 1;
+			}
+			return sizes;
+		}
+
+		Options parseOptions(int argc, char** argv) {
+			Options options;
+			for (int i = 1; i < argc; i++) {
+				std::string arg = argv[i];
+				auto value = [&]() -> std::string {
+					if (i + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+					return argv[++i];
+				};
+				if (arg == "--sizes") options.sizes = parseSizes(value());
+				else if (arg == "--repeat") options.repeat = std::max<size_t>(1, std::stoull(value()));
+				else if (arg == "--filter") options.filter = value();
+				else if (arg == "--format") options.json = value() == "json";
+				else if (arg == "--storage") {
+					std::string storage = value();
+					if (storage == "archetype") options.storages = { TeStoragePolicy::Archetype };
+					else if (storage == "sparse_set") options.storages = { TeStoragePolicy::SparseSet };
+					else if (storage != "all") throw std::runtime_error("unknown storage " + storage);
+				}
+				else {
+					throw std::runtime_error("usage: te_ecs_benchmark [--sizes 1000,10000] [--repeat n] [--filter name] [--format csv|json] [--storage archetype|sparse_set|all]");
+				}
+			}
+			return options;
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace te;
+	Options options;
+	try {
+		options = parseOptions(argc, argv);
+	}
+	catch (const std::exception& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	if (!options.json) {
+		std::printf("benchmark,storage,entities,seconds,ns_per_entity\n");
+	}
+	for (const Benchmark& benchmark : BENCHMARKS) {
+		if (!options.filter.empty() && std::string(benchmark.name).find(options.filter) == std::string::npos) continue;
+		for (TeStoragePolicy storage : options.storages) {
+			for (size_t count : options.sizes) {
+				std::fprintf(stderr, "%s/%s/%zu\n", benchmark.name, storageName(storage), count);
+				double best = 0.0;
+				for (size_t i = 0; i < options.repeat; i++) {
+					double seconds = benchmark.func(storage, count);
+					best = i == 0 ? seconds : std::min(best, seconds);
+				}
+				double perEntity = count ? best * 1e9 / count : 0.0;
+				if (options.json) {
+					std::printf("{\"benchmark\":\"%s\",\"storage\":\"%s\",\"entities\":%zu,\"seconds\":%.9f,\"ns_per_entity\":%.3f}\n", benchmark.name, storageName(storage), count, best, perEntity);
+				}
+				else {
+					std::printf("%s,%s,%zu,%.9f,%.3f\n", benchmark.name, storageName(storage), count, best, perEntity);
+				}
+				std::fflush(stdout);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,630 @@
+// Headless ECS tests. Each case sets up its own TeECS and throws on the first failed check, the
+// program prints every case's result and exits non-zero if any failed. A case name given on the
+// command line runs only the cases containing it
+#include "te_compression.hpp"
+#include "te_ecs.hpp"
+#include "te_entity_command_buffer.hpp"
+#include "te_scene_capture.hpp"
+#include "te_scheduler.hpp"
+#include "te_snapshot.hpp"
+#include "te_snapshot_delta.hpp"
+
+#include <cstdio>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace te {
+	namespace {
+		struct TestPosition {
+			float x = 0.f, y = 0.f, z = 0.f;
+
+			static constexpr auto fields() { return teFields("TestPosition", TE_FIELD(TestPosition, x), TE_FIELD(TestPosition, y), TE_FIELD(TestPosition, z)); }
+		};
+
+		struct TestHealth {
+			int32_t value = 100;
+
+			static constexpr auto fields() { return teFields("TestHealth", TE_FIELD(TestHealth, value)); }
+		};
+
+		// Counts live instances, copying one made with throwOnCopy throws
+		template<int N>
+		struct TestThrowing {
+			static inline int live = 0;
+
+			int value = 0;
+			bool throwOnCopy = false;
+
+			TestThrowing(int value, bool throwOnCopy = false) : value{ value }, throwOnCopy{ throwOnCopy } { live++; }
+			TestThrowing(const TestThrowing& other) : value{ other.value } {
+				if (other.throwOnCopy) {
+					throw std::runtime_error("copy failed");
+				}
+				live++;
+			}
+			TestThrowing(TestThrowing&& other) noexcept : value{ other.value }, throwOnCopy{ other.throwOnCopy } { live++; }
+			TestThrowing& operator=(TestThrowing&&) = default;
+			~TestThrowing() { live--; }
+		};
+
+		// Counts live instances, moving one throws while failMoves is set
+		struct TestThrowingMove {
+			static inline int live = 0;
+			static inline bool failMoves = false;
+
+			TestThrowingMove() { live++; }
+			TestThrowingMove(const TestThrowingMove&) { live++; }
+			TestThrowingMove(TestThrowingMove&&) {
+				if (failMoves) {
+					throw std::runtime_error("move failed");
+				}
+				live++;
+			}
+			~TestThrowingMove() { live--; }
+		};
+
+		using Entity = TeScene::Entity;
+
+		void check(bool condition, const char* what) {
+			if (!condition) {
+				throw std::runtime_error(what);
+			}
+		}
+
+		struct Fixture {
+			Fixture() {
+				ecs.registerComponent<TestPosition>();
+				ecs.registerComponent<TestHealth>(TeStoragePolicy::SparseSet);
+				scene = ecs.getScene(ecs.createScene());
+				scene->setLogging(false);
+			}
+
+			std::vector<Entity> populate(size_t count) {
+				std::vector<Entity> entities = scene->createEntities(count);
+				for (size_t i = 0; i < count; i++) {
+					scene->addComponent(entities[i], TestPosition{ static_cast<float>(i), 0.f, 0.f });
+					scene->addComponent(entities[i], TestHealth{});
+				}
+				return entities;
+			}
+
+			TeECS ecs;
+			TeScene* scene;
+		};
+
+		// A frame's sync point while an autosave holds a capture: empty playback copies nothing, and
+		// a structural change copies only the entity table and the chunks and pool it touches
+		void testCaptureSyncPointCopiesOnlyTouchedBlocks() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(100000);
+			std::shared_ptr<TeSceneCapture> capture = fixture.scene->capture();
+			size_t blocks = capture->getRemainingBlocks();
+			check(blocks > 100, "the scene should span many blocks");
+
+			TeEntityCommandBuffer commands;
+			commands.playback(*fixture.scene);
+			check(capture->getRemainingBlocks() == blocks, "an empty playback copied blocks");
+
+			Entity created = commands.createEntity();
+			commands.addComponent(created, TestPosition{ -1.f, 0.f, 0.f });
+			commands.destroyEntity(entities[0]);
+			commands.playback(*fixture.scene);
+			// The entity table, the destroyed entity's chunk, the archetype's last chunk and the pool's two blocks
+			check(blocks - capture->getRemainingBlocks() <= 5, "a structural change copied blocks it didn't touch");
+
+			std::vector<char> snapshot = std::async(std::launch::async, [capture] { return capture->saveSnapshot(); }).get();
+			TeScene* loaded = fixture.ecs.getScene(fixture.ecs.createScene());
+			loaded->setLogging(false);
+			std::vector<Entity> restored = loaded->loadSnapshot(snapshot);
+			check(restored.size() == entities.size(), "the capture should hold the scene as it was when taken");
+			const TestPosition* position = loaded->getComponent<const TestPosition>(restored[0]);
+			check(position && position->x == 0.f, "the first entity's position should survive its destruction");
+			position = loaded->getComponent<const TestPosition>(restored.back());
+			check(position && position->x == static_cast<float>(entities.size() - 1), "the moved last row should keep its position");
+		}
+
+		// Non-const access stamps change versions, so inside a system it needs writes<>(), including
+		// on the helpers of a parallelFor the system starts
+		void testSystemWriteAccess() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(1000);
+			TeWorkerPool workers{ 3 };
+			TeSystemScheduler scheduler{ workers };
+			scheduler.addSystem("writer", [&] {
+				workers.parallelFor(entities.size(), [&](size_t i) {
+					fixture.scene->getComponent<TestPosition>(entities[i])->y = 1.f;
+				});
+			}).writes<TestPosition>();
+			scheduler.run(*fixture.scene);
+			check(fixture.scene->getComponentCopy<TestPosition>(entities.back())->y == 1.f, "the declared write should go through");
+
+			TeSystemScheduler undeclared{ workers };
+			undeclared.addSystem("reader", [&] {
+				fixture.scene->view<TestPosition>().each([](Entity, TestPosition& position) { position.y = 2.f; });
+			}).reads<TestPosition>();
+			bool threw = false;
+			try {
+				undeclared.run(*fixture.scene);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw, "non-const access from a system that only reads should throw");
+			check(fixture.scene->getComponent<TestPosition>(entities[0]) != nullptr, "outside a run the owning thread may write");
+		}
+
+		template<int N>
+		void checkThrowingAdd(TeScene& scene) {
+			using Component = TestThrowing<N>;
+			Entity entity = scene.createEntity();
+			Component bad{ 2, true };
+			bool threw = false;
+			try {
+				scene.addComponent(entity, bad);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw && !scene.getComponentCopy<Component>(entity), "a failed add should leave the entity without the component");
+
+			scene.addComponent(entity, Component{ 1 });
+			threw = false;
+			try {
+				scene.addComponent(entity, bad);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw && scene.getComponentCopy<Component>(entity)->value == 1, "a failed replace should keep the previous component");
+			scene.destroyEntity(entity);
+		}
+
+		// A component whose constructor throws is never counted as added, and the scene lock is released
+		void testAddComponentThrowing() {
+			{
+				Fixture fixture;
+				fixture.ecs.registerComponent<TestThrowing<1>>(TeStoragePolicy::SparseSet);
+				checkThrowingAdd<0>(*fixture.scene);
+				checkThrowingAdd<1>(*fixture.scene);
+			}
+			check(TestThrowing<0>::live == 0 && TestThrowing<1>::live == 0, "every constructed component should be destroyed exactly once");
+		}
+
+		// A playback that throws part way keeps what it applied, drops the rest, destroys every payload
+		// once and leaves both the scene and the buffer unlocked
+		void testPlaybackThrowing() {
+			{
+				Fixture fixture;
+				TeEntityCommandBuffer commands;
+				Entity first = commands.createEntity();
+				commands.addComponent(first, TestPosition{ 1.f, 0.f, 0.f });
+				Entity second = commands.createEntity();
+				commands.addComponent(second, TestPosition{ 2.f, 0.f, 0.f });
+				commands.addComponent(second, TestThrowingMove{});
+				commands.addComponent(commands.createEntity(), TestThrowingMove{});
+
+				TestThrowingMove::failMoves = true;
+				bool threw = false;
+				try {
+					commands.playback(*fixture.scene);
+				}
+				catch (const std::runtime_error&) {
+					threw = true;
+				}
+				TestThrowingMove::failMoves = false;
+				check(threw && commands.isEmpty(), "a failed playback should throw and still clear the buffer");
+				std::vector<Entity> entities = fixture.scene->getEntities();
+				check(entities.size() == 2, "the commands before the failure should stay applied");
+				check(fixture.scene->getComponentCopy<TestPosition>(entities[0])->x == 1.f, "the first entity should have its position");
+				check(!fixture.scene->getComponentCopy<TestPosition>(entities[1]), "the failed batch shouldn't be partly added");
+
+				commands.addComponent(entities[1], TestThrowingMove{});
+				commands.playback(*fixture.scene);
+				fixture.scene->addComponent(entities[1], TestPosition{ 3.f, 0.f, 0.f });
+				check(fixture.scene->getComponentCopy<TestPosition>(entities[1])->x == 3.f, "both locks should be free after a failed playback");
+			}
+			check(TestThrowingMove::live == 0, "every payload should be destroyed exactly once");
+		}
+
+		// A deserialized entity arrives with its name and every component at once
+		void testEntityRoundTrip() {
+			Fixture fixture;
+			Entity entity = fixture.scene->createEntity("archer");
+			fixture.scene->addComponent(entity, TestPosition{ 1.f, 2.f, 3.f });
+			fixture.scene->addComponent(entity, TestHealth{ 42 });
+			std::vector<char> data = fixture.scene->serializeEntity(entity);
+
+			TeScene* loaded = fixture.ecs.getScene(fixture.ecs.createScene());
+			loaded->setLogging(false);
+			Entity restored = loaded->deserializeEntity(data);
+			check(loaded->getEntityName(restored) == "archer" && loaded->getEntityByName("archer") == restored, "the entity should keep its name");
+			std::optional<TestPosition> position = loaded->getComponentCopy<TestPosition>(restored);
+			check(position && position->x == 1.f && position->y == 2.f && position->z == 3.f, "the position should round trip");
+			check(loaded->getComponentCopy<TestHealth>(restored)->value == 42, "the health should round trip");
+
+			data.resize(data.size() - 1);
+			bool threw = false;
+			try {
+				loaded->deserializeEntity(data);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw && loaded->getEntities().size() == 1, "truncated data should throw without adding an entity");
+		}
+
+		// A registration id from the data past the registered components is rejected, not indexed
+		void testDeserializeComponentUnregistered() {
+			Fixture fixture;
+			std::vector<char> data;
+			TeArchiveWriter writer{ data };
+			writer.write<size_t>(1000);
+			writer.write<int32_t>(7);
+			for (int attempt = 0; attempt < 2; attempt++) {
+				bool threw = false;
+				try {
+					fixture.ecs.deserializeComponent(data);
+				}
+				catch (const std::runtime_error&) {
+					threw = true;
+				}
+				check(threw, "an unregistered id should throw, again once the ECS lock is released");
+			}
+		}
+
+		// A serialized section claiming far more components than its blob could frame is rejected
+		// before loading allocates room for all of them
+		void testSnapshotCountBoundedByBlob() {
+			const size_t count = 100000;
+			std::vector<char> snapshot;
+			TeArchiveWriter writer{ snapshot };
+			TeSnapshotHeader header{};
+			header.entityCount = count;
+			header.componentTypeCount = 1;
+			writer.write(header);
+			for (size_t i = 0; i < count; i++) {
+				writer.write<uint32_t>(0);
+			}
+			for (uint32_t i = 0; i < count; i++) {
+				writer.write(TeEntity{ i, 0 });
+			}
+			TeSnapshotComponentHeader section{};
+			section.count = count;
+			section.blobBytes = sizeof(uint64_t);
+			writer.write(section);
+			for (uint32_t i = 0; i < count; i++) {
+				writer.write(i);
+			}
+			writer.align(TeSnapshotHeader::BLOB_ALIGNMENT, 0);
+			writer.write<uint64_t>(0);
+
+			bool threw = false;
+			try {
+				TeSnapshotView view{ snapshot.data(), snapshot.size() };
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw, "a blob too small for its component count should be rejected");
+		}
+
+		// Sections of raw 4 byte components, each a registration id and the entity table indices it covers
+		std::vector<char> writeSnapshot(uint32_t entityCount, const std::vector<std::pair<uint64_t, std::vector<uint32_t>>>& sections) {
+			std::vector<char> snapshot;
+			TeArchiveWriter writer{ snapshot };
+			TeSnapshotHeader header{};
+			header.entityCount = entityCount;
+			header.componentTypeCount = sections.size();
+			writer.write(header);
+			for (uint32_t i = 0; i < entityCount; i++) {
+				writer.write<uint32_t>(0);
+			}
+			for (uint32_t i = 0; i < entityCount; i++) {
+				writer.write(TeEntity{ i, 0 });
+			}
+			for (auto& [componentId, indices] : sections) {
+				TeSnapshotComponentHeader section{};
+				section.componentId = componentId;
+				section.count = indices.size();
+				section.elementSize = sizeof(int32_t);
+				section.blobBytes = indices.size() * sizeof(int32_t);
+				writer.write(section);
+				for (uint32_t index : indices) {
+					writer.write(index);
+				}
+				writer.align(TeSnapshotHeader::BLOB_ALIGNMENT, 0);
+				for (size_t i = 0; i < indices.size(); i++) {
+					writer.write<int32_t>(0);
+				}
+			}
+			return snapshot;
+		}
+
+		bool rejectsSnapshot(const std::vector<char>& snapshot) {
+			try {
+				TeSnapshotView view{ snapshot.data(), snapshot.size() };
+			}
+			catch (const std::runtime_error&) {
+				return true;
+			}
+			return false;
+		}
+
+		// Loading would construct over a component it already placed, so repeats are rejected up front
+		void testSnapshotRejectsRepeats() {
+			check(!rejectsSnapshot(writeSnapshot(2, { { 0, { 0, 1 } }, { 1, { 1 } } })), "a well formed snapshot should be accepted");
+			check(rejectsSnapshot(writeSnapshot(2, { { 0, { 1, 1 } } })), "an entity with the same component twice should be rejected");
+			check(rejectsSnapshot(writeSnapshot(2, { { 1, { 0 } }, { 1, { 1 } } })), "two sections for one component type should be rejected");
+		}
+
+		// The name table is shared and only grows, so a snapshot that's rejected mustn't add to it
+		void testRejectedSnapshotInternsNoNames() {
+			Fixture fixture;
+			Entity entity = fixture.scene->createEntity("rejected_name");
+			fixture.scene->addComponent(entity, TestPosition{});
+			std::vector<char> snapshot = fixture.scene->saveSnapshot();
+
+			TeECS other;
+			TeScene* scene = other.getScene(other.createScene());
+			bool threw = false;
+			try {
+				scene->loadSnapshot(snapshot);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw, "a snapshot with unregistered components should be rejected");
+			check(other.getNameTable().find("rejected_name") == TeNameTable::NONE, "the rejected snapshot's names shouldn't be interned");
+		}
+
+		// The first incremental save has no base to compare against, so it's a full snapshot that
+		// becomes the base, and the next call returns a delta from it
+		void testSnapshotDeltaFirstSave() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(100);
+			std::vector<char> base;
+			std::vector<char> first = fixture.scene->saveSnapshotDelta(base);
+			check(!base.empty() && first == base, "the first save should return the full snapshot and seed base with it");
+
+			TeScene* loaded = fixture.ecs.getScene(fixture.ecs.createScene());
+			loaded->setLogging(false);
+			check(loaded->loadSnapshot(first).size() == entities.size(), "the first save should load as a snapshot");
+
+			fixture.scene->getComponent<TestPosition>(entities[3])->y = 5.f;
+			std::vector<char> previous = base;
+			std::vector<char> delta = fixture.scene->saveSnapshotDelta(base);
+			check(TeSnapshotDelta::apply(previous, delta) == base, "the second save should be a delta from the first");
+		}
+
+		// Replaying the saved chain steps the scene back through every save, whatever it holds now
+		void testSnapshotDeltaRollback() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(10);
+			std::vector<char> base;
+			std::vector<std::vector<char>> saves;
+			saves.push_back(fixture.scene->saveSnapshotDelta(base));
+			fixture.scene->getComponent<TestPosition>(entities[2])->y = 7.f;
+			fixture.scene->destroyEntity(entities[5]);
+			saves.push_back(fixture.scene->saveSnapshotDelta(base));
+			check(!TeSnapshotDelta::isDelta(saves[0]) && TeSnapshotDelta::isDelta(saves[1]), "the first save should be full and the next a delta");
+
+			fixture.scene->destroyEntities(fixture.scene->getEntities());
+			fixture.scene->createEntity("stray");
+			std::vector<char> replayed;
+			std::vector<Entity> restored = fixture.scene->restoreSnapshotDelta(replayed, saves[0]);
+			check(restored.size() == 10 && fixture.scene->getEntities().size() == 10, "restoring should replace everything in the scene");
+			check(fixture.scene->getComponentCopy<TestPosition>(restored[2])->y == 0.f, "the first save had the original position");
+
+			restored = fixture.scene->restoreSnapshotDelta(replayed, saves[1]);
+			check(restored.size() == 9 && fixture.scene->getEntities().size() == 9, "the delta should bring back the later entity count");
+			check(fixture.scene->getComponentCopy<TestPosition>(restored[2])->y == 7.f, "the delta should bring back the later position");
+
+			bool threw = false;
+			try {
+				fixture.scene->restoreSnapshotDelta(replayed, saves[1]);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			check(threw && fixture.scene->getEntities().size() == 9, "a delta from another base should throw and leave the scene as it was");
+		}
+
+		template<typename F>
+		bool throws(F&& func) {
+			try {
+				func();
+			}
+			catch (const std::runtime_error&) {
+				return true;
+			}
+			return false;
+		}
+
+		// Every entity and component comes back from a saved snapshot, and a cut short one is
+		// rejected without touching the scene it was loaded into
+		void testSnapshotRoundTrip() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(1000);
+			fixture.scene->removeComponent<TestHealth>(entities[10]);
+			fixture.scene->getComponent<TestHealth>(entities[20])->value = 7;
+			std::vector<char> snapshot = fixture.scene->saveSnapshot();
+
+			TeScene* loaded = fixture.ecs.getScene(fixture.ecs.createScene());
+			loaded->setLogging(false);
+			std::vector<Entity> restored = loaded->loadSnapshot(snapshot);
+			check(restored.size() == entities.size(), "every entity should be restored");
+			for (size_t i = 0; i < restored.size(); i++) {
+				std::optional<TestPosition> position = loaded->getComponentCopy<TestPosition>(restored[i]);
+				check(position && position->x == static_cast<float>(i), "positions should round trip in entity order");
+			}
+			check(!loaded->getComponentCopy<TestHealth>(restored[10]), "a removed component should stay removed");
+			check(loaded->getComponentCopy<TestHealth>(restored[20])->value == 7, "a written component should keep its value");
+			check(loaded->saveSnapshot() == snapshot, "saving the loaded scene should give the same snapshot");
+
+			Entity survivor = loaded->createEntity();
+			loaded->destroyEntities(restored);
+			for (size_t size : { size_t{ 0 }, sizeof(TeSnapshotHeader) - 1, snapshot.size() / 2, snapshot.size() - 1 }) {
+				std::vector<char> truncated(snapshot.begin(), snapshot.begin() + size);
+				check(throws([&] { loaded->loadSnapshot(truncated); }), "a truncated snapshot should be rejected");
+			}
+			check(loaded->getEntities() == std::vector<Entity>{ survivor }, "a rejected snapshot shouldn't add or remove entities");
+		}
+
+		// A delta applied to the snapshot it was made from gives back the later snapshot, and a delta
+		// that's cut short or made from another base is rejected
+		void testSnapshotDeltaRoundTrip() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(1000);
+			std::vector<char> base = fixture.scene->saveSnapshot();
+			fixture.scene->getComponent<TestPosition>(entities[1])->z = 3.f;
+			fixture.scene->destroyEntity(entities[2]);
+			fixture.scene->addComponent(fixture.scene->createEntity("late"), TestHealth{ 5 });
+			std::vector<char> target = fixture.scene->saveSnapshot();
+
+			std::vector<char> delta = TeSnapshotDelta::create(base, target);
+			check(TeSnapshotDelta::isDelta(delta) && !TeSnapshotDelta::isDelta(base), "only the delta should be taken for one");
+			check(delta.size() < target.size() / 4, "a delta of a few changes should be much smaller than the snapshot");
+			// The applied snapshot may order a pool differently, so it's compared by what it loads as
+			TeScene* applied = fixture.ecs.getScene(fixture.ecs.createScene());
+			applied->setLogging(false);
+			std::vector<Entity> appliedEntities = applied->loadSnapshot(TeSnapshotDelta::apply(base, delta));
+			TeScene* expected = fixture.ecs.getScene(fixture.ecs.createScene());
+			expected->setLogging(false);
+			std::vector<Entity> expectedEntities = expected->loadSnapshot(target);
+			check(appliedEntities.size() == expectedEntities.size(), "applying the delta should give the later entity count");
+			for (size_t i = 0; i < appliedEntities.size(); i++) {
+				std::optional<TestPosition> position = applied->getComponentCopy<TestPosition>(appliedEntities[i]);
+				std::optional<TestPosition> expectedPosition = expected->getComponentCopy<TestPosition>(expectedEntities[i]);
+				std::optional<TestHealth> health = applied->getComponentCopy<TestHealth>(appliedEntities[i]);
+				std::optional<TestHealth> expectedHealth = expected->getComponentCopy<TestHealth>(expectedEntities[i]);
+				check(applied->getEntityName(appliedEntities[i]) == expected->getEntityName(expectedEntities[i]), "applying the delta should give the later names");
+				check(position.has_value() == expectedPosition.has_value() && (!position || (position->x == expectedPosition->x && position->z == expectedPosition->z)), "applying the delta should give the later positions");
+				check(health.has_value() == expectedHealth.has_value() && (!health || health->value == expectedHealth->value), "applying the delta should give the later health");
+			}
+
+			for (size_t size : { sizeof(TeSnapshotDeltaHeader) - 1, sizeof(TeSnapshotDeltaHeader), delta.size() - 1 }) {
+				std::vector<char> truncated(delta.begin(), delta.begin() + size);
+				check(throws([&] { TeSnapshotDelta::apply(base, truncated); }), "a truncated delta should be rejected");
+			}
+			check(throws([&] { TeSnapshotDelta::apply(writeSnapshot(2, {}), delta); }), "a delta applied to another base should be rejected");
+		}
+
+		// Data spanning several blocks decompresses to what went in, serially and with workers, and
+		// compressed data that's cut short is rejected
+		void testCompressionRoundTrip() {
+			std::vector<char> data(TeCompression::BLOCK_SIZE * 2 + 1000);
+			uint32_t state = 1;
+			for (size_t i = 0; i < data.size(); i++) {
+				// Runs of text broken up by noise, so both matches and literals get exercised
+				state = state * 1664525u + 1013904223u;
+				data[i] = (i / 64) % 3 == 0 ? static_cast<char>(state >> 24) : "the quick brown fox "[i % 20];
+			}
+			TeWorkerPool workers{ 3 };
+			std::vector<char> compressed = TeCompression::compress(data);
+			check(TeCompression::isCompressed(compressed) && !TeCompression::isCompressed(data), "only the compressed data should be taken for it");
+			check(compressed.size() < data.size(), "repetitive data should compress");
+			check(TeCompression::compress(data, &workers) == compressed, "compressing in parallel should give the same bytes");
+			check(TeCompression::decompress(compressed) == data, "decompressing should give back the data");
+			check(TeCompression::decompress(compressed, &workers) == data, "decompressing in parallel should give back the data");
+			check(TeCompression::decompress(TeCompression::compress(std::vector<char>{})).empty(), "empty data should round trip");
+
+			for (size_t size : { sizeof(TeCompressedHeader) - 1, sizeof(TeCompressedHeader), compressed.size() / 2, compressed.size() - 1 }) {
+				std::vector<char> truncated(compressed.begin(), compressed.begin() + size);
+				check(throws([&] { TeCompression::decompress(truncated); }), "truncated compressed data should be rejected");
+				check(throws([&] { TeCompression::decompress(truncated, &workers); }), "truncated compressed data should be rejected in parallel");
+			}
+		}
+
+		// Commands apply in the order they were recorded, pending handles resolve to the entities
+		// their creations made, and commands for handles that don't resolve are skipped
+		void testPlaybackOrder() {
+			Fixture fixture;
+			std::vector<Entity> entities = fixture.populate(3);
+			TeEntityCommandBuffer commands;
+			Entity first = commands.createEntity("first");
+			Entity second = commands.createEntity();
+			check(TeEntityCommandBuffer::isPending(first) && TeEntityCommandBuffer::isPending(second), "handles from the buffer should be pending");
+			commands.addComponent(second, TestPosition{ 2.f, 0.f, 0.f });
+			commands.addComponent(first, TestPosition{ 1.f, 0.f, 0.f });
+			commands.addComponent(first, TestHealth{ 10 });
+			commands.removeComponent<TestHealth>(first);
+			commands.addComponent(first, TestHealth{ 11 });
+			commands.destroyEntity(second);
+			commands.destroyEntity(entities[0]);
+			commands.removeComponent<TestPosition>(entities[1]);
+			std::vector<Entity> created = commands.playback(*fixture.scene);
+
+			check(created.size() == 2 && !TeEntityCommandBuffer::isPending(created[0]), "playback should return the created entities");
+			check(fixture.scene->getEntityByName("first") == created[0], "a created entity should keep its name");
+			check(fixture.scene->getComponentCopy<TestPosition>(created[0])->x == 1.f, "components should land on the entity their handle named");
+			check(fixture.scene->getComponentCopy<TestHealth>(created[0])->value == 11, "a remove between two adds should apply in between");
+			check(!fixture.scene->getComponentCopy<TestPosition>(created[1]), "an entity created and destroyed in one playback should be gone");
+			check(!fixture.scene->getComponentCopy<TestHealth>(entities[0]), "a destroyed entity should lose its components");
+			check(!fixture.scene->getComponentCopy<TestPosition>(entities[1]) && fixture.scene->getComponentCopy<TestHealth>(entities[1]), "only the removed component should go");
+
+			// A pending handle only means something to the buffer that made it, and a destroyed
+			// entity's handle is stale, so neither may touch whatever entity holds the index now
+			Entity reused = fixture.scene->createEntity();
+			fixture.scene->addComponent(reused, TestPosition{ 4.f, 0.f, 0.f });
+			check(reused.index == entities[0].index || reused.index == created[1].index, "a new entity should reuse a freed index");
+			TeEntityCommandBuffer other;
+			Entity foreign = other.createEntity();
+			commands.addComponent(foreign, TestPosition{ -1.f, 0.f, 0.f });
+			for (Entity stale : { entities[0], created[1] }) {
+				commands.addComponent(stale, TestPosition{ -1.f, 0.f, 0.f });
+				commands.removeComponent<TestPosition>(stale);
+				commands.destroyEntity(stale);
+			}
+			std::vector<Entity> before = fixture.scene->getEntities();
+			check(commands.playback(*fixture.scene).empty(), "a buffer that created nothing should return nothing");
+			check(fixture.scene->getEntities() == before, "commands for handles that don't resolve should be skipped");
+			check(fixture.scene->getComponentCopy<TestPosition>(reused)->x == 4.f, "a stale handle shouldn't reach the entity reusing its index");
+			fixture.scene->view<const TestPosition>().each([](Entity, const TestPosition& position) {
+				check(position.x != -1.f, "a component for a handle that doesn't resolve shouldn't be added anywhere");
+			});
+		}
+
+		struct Test {
+			const char* name;
+			void (*func)();
+		};
+
+		const Test TESTS[] = {
+			{ "capture_sync_point", &testCaptureSyncPointCopiesOnlyTouchedBlocks },
+			{ "system_write_access", &testSystemWriteAccess },
+			{ "add_component_throwing", &testAddComponentThrowing },
+			{ "playback_throwing", &testPlaybackThrowing },
+			{ "entity_round_trip", &testEntityRoundTrip },
+			{ "component_unregistered_id", &testDeserializeComponentUnregistered },
+			{ "snapshot_count_bound", &testSnapshotCountBoundedByBlob },
+			{ "snapshot_repeats", &testSnapshotRejectsRepeats },
+			{ "snapshot_rejected_names", &testRejectedSnapshotInternsNoNames },
+			{ "snapshot_delta_first_save", &testSnapshotDeltaFirstSave },
+			{ "snapshot_delta_rollback", &testSnapshotDeltaRollback },
+			{ "snapshot_round_trip", &testSnapshotRoundTrip },
+			{ "snapshot_delta_round_trip", &testSnapshotDeltaRoundTrip },
+			{ "compression_round_trip", &testCompressionRoundTrip },
+			{ "playback_order", &testPlaybackOrder },
+		};
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace te;
+	std::string filter = argc > 1 ? argv[1] : "";
+	int failed = 0;
+	for (const Test& test : TESTS) {
+		if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos) continue;
+		try {
+			test.func();
+			std::printf("passed %s\n", test.name);
+		}
+		catch (const std::exception& e) {
+			std::printf("FAILED %s: %s\n", test.name, e.what());
+			failed++;
+		}
+	}
+	return failed ? 1 : 0;
+}